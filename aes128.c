@@ -11,7 +11,7 @@
    It's expected the store would be implemented in some hardware registers (think TRESOR of linux-x86).
 
    The flow is:
-    1) aes128_set_key(key)
+    1) aes128_set_key(key). In the AES128_EXPANDED_KEY mode it expands the key schedule too
     2) aes128_set_data(plaintext)
     3) aes128_encrypt()
     4) ciphertext = aes128_get_data(plaintext)
@@ -20,11 +20,17 @@
    NOTES:
     Since the store is singleton, only one AES instance may be running at time.
     No thread-safety, of course.
+    If it's a problem, use the aes128_ctx_* functions. They take the explicit per-instance context
+    with the expanded key and keep the state in locals, so any number of instances may run concurrently.
     Only little-endian mode is supported.
     It's advised to inspect the resulting assembly to make sure no stack is actually used.
 
+    If keeping the key schedule in store is acceptable, build with AES128_EXPANDED_KEY=1.
+    The round keys are expanded once per key and the encryption gets about twice faster.
+
 
    Yes, this AES is quite slow :-)
+   If the speed matters more than the cache-timing resistance, see aes128tt (T-tables).
 
 */
 
@@ -92,17 +98,24 @@ static inline uint32_t mix_column(uint32_t col)
     return xtime32(col ^ rotr32(col, 8)) ^ rotr32(col, 8) ^ rotr32(col, 16) ^ rotr32(col, 24);
 }
 
-static void do_round(int rcon)
+// first word of the next round key is w0 ^ key_core(w3)
+static inline uint32_t key_core(uint32_t w3, int rcon)
 {
-    uint32_t rk3 = aes128_ldreg(AES128_RK3);
-    uint32_t tmp = rk3;
+    return (xbsb(w3, 1, 0) ^ rcon) | xbsb(w3, 2, 1) | xbsb(w3, 3, 2) | xbsb(w3, 0, 3);
+}
 
-    tmp =  (xbsb(tmp, 1, 0) ^ rcon) | xbsb(tmp, 2, 1) | xbsb(tmp, 3, 2) | xbsb(tmp, 0, 3);
+static inline int next_rcon(int rcon)
+{
+    return rcon == 0x80 ? 0x1B : rcon << 1;
+}
 
-    uint32_t c0 = aes128_ldreg(AES128_S0);
-    uint32_t c1 = aes128_ldreg(AES128_S1);
-    uint32_t c2 = aes128_ldreg(AES128_S2);
-    uint32_t c3 = aes128_ldreg(AES128_S3);
+// SubBytes, ShiftRows and MixColumns (except the last round) on the state columns
+static inline void sub_shift_mix(uint32_t *pc0, uint32_t *pc1, uint32_t *pc2, uint32_t *pc3, int last)
+{
+    uint32_t c0 = *pc0;
+    uint32_t c1 = *pc1;
+    uint32_t c2 = *pc2;
+    uint32_t c3 = *pc3;
 
     uint32_t r0 = xbsb(c0, 0, 0) | xbsb(c1, 0, 1) | xbsb(c2, 0, 2) | xbsb(c3, 0, 3);
     uint32_t r1 = xbsb(c1, 1, 0) | xbsb(c2, 1, 1) | xbsb(c3, 1, 2) | xbsb(c0, 1, 3);
@@ -114,7 +127,7 @@ static void do_round(int rcon)
     c2 = xb(r0, 2,  0) | xb(r1, 2, 1) | xb(r2, 2, 2) | xb(r3, 2, 3);
     c3 = xb(r0, 3,  0) | xb(r1, 3, 1) | xb(r2, 3, 2) | xb(r3, 3, 3);
 
-    if (rcon != 0x36)
+    if (!last)
     {
         c0 = mix_column(c0);
         c1 = mix_column(c1);
@@ -122,6 +135,24 @@ static void do_round(int rcon)
         c3 = mix_column(c3);
     }
 
+    *pc0 = c0;
+    *pc1 = c1;
+    *pc2 = c2;
+    *pc3 = c3;
+}
+
+static void do_round(int rcon)
+{
+    uint32_t rk3 = aes128_ldreg(AES128_RK3);
+    uint32_t tmp = key_core(rk3, rcon);
+
+    uint32_t c0 = aes128_ldreg(AES128_S0);
+    uint32_t c1 = aes128_ldreg(AES128_S1);
+    uint32_t c2 = aes128_ldreg(AES128_S2);
+    uint32_t c3 = aes128_ldreg(AES128_S3);
+
+    sub_shift_mix(&c0, &c1, &c2, &c3, rcon == 0x36);
+
     tmp ^= aes128_ldreg(AES128_RK0);
     aes128_streg(AES128_RK0, tmp);
     aes128_streg(AES128_S0, c0 ^ tmp);
@@ -139,6 +170,22 @@ static void do_round(int rcon)
     aes128_streg(AES128_S3, c3 ^ tmp);
 }
 
+// same as above, but with the round keys from the expanded key
+static void do_round_xk(int xk, int last)
+{
+    uint32_t c0 = aes128_ldreg(AES128_S0);
+    uint32_t c1 = aes128_ldreg(AES128_S1);
+    uint32_t c2 = aes128_ldreg(AES128_S2);
+    uint32_t c3 = aes128_ldreg(AES128_S3);
+
+    sub_shift_mix(&c0, &c1, &c2, &c3, last);
+
+    aes128_streg(AES128_S0, c0 ^ aes128_ldreg(xk + 0));
+    aes128_streg(AES128_S1, c1 ^ aes128_ldreg(xk + 1));
+    aes128_streg(AES128_S2, c2 ^ aes128_ldreg(xk + 2));
+    aes128_streg(AES128_S3, c3 ^ aes128_ldreg(xk + 3));
+}
+
 
 void aes128_set_key(const uint8_t key[16])
 {
@@ -146,6 +193,40 @@ void aes128_set_key(const uint8_t key[16])
     aes128_streg(AES128_K1, u8to32le(&key[4]));
     aes128_streg(AES128_K2, u8to32le(&key[8]));
     aes128_streg(AES128_K3, u8to32le(&key[12]));
+
+    if (AES128_EXPANDED_KEY)
+        aes128_expand_key();
+}
+
+void aes128_expand_key(void)
+{
+    if (!AES128_EXPANDED_KEY)
+        return;
+
+    uint32_t w0 = aes128_ldreg(AES128_K0);
+    uint32_t w1 = aes128_ldreg(AES128_K1);
+    uint32_t w2 = aes128_ldreg(AES128_K2);
+    uint32_t w3 = aes128_ldreg(AES128_K3);
+
+    int rcon = 0x01;
+
+    for (int xk = AES128_XK0; ; xk += 4)
+    {
+        aes128_streg(xk + 0, w0);
+        aes128_streg(xk + 1, w1);
+        aes128_streg(xk + 2, w2);
+        aes128_streg(xk + 3, w3);
+
+        if (xk == AES128_XK0 + 40)
+            break;
+
+        w0 ^= key_core(w3, rcon);
+        w1 ^= w0;
+        w2 ^= w1;
+        w3 ^= w2;
+
+        rcon = next_rcon(rcon);
+    }
 }
 
 void aes128_set_data(const uint8_t src[16])
@@ -179,11 +260,36 @@ void aes128_clear_key(void)
     aes128_streg(AES128_K1, 0);
     aes128_streg(AES128_K2, 0);
     aes128_streg(AES128_K3, 0);
+
+    if (AES128_EXPANDED_KEY)
+    {
+        for (int i = 0; i < 44; i++)
+            aes128_streg(AES128_XK0 + i, 0);
+    }
 }
 
 
+static void encrypt_xk(void)
+{
+    aes128_streg(AES128_S0, aes128_ldreg(AES128_S0) ^ aes128_ldreg(AES128_XK0 + 0));
+    aes128_streg(AES128_S1, aes128_ldreg(AES128_S1) ^ aes128_ldreg(AES128_XK0 + 1));
+    aes128_streg(AES128_S2, aes128_ldreg(AES128_S2) ^ aes128_ldreg(AES128_XK0 + 2));
+    aes128_streg(AES128_S3, aes128_ldreg(AES128_S3) ^ aes128_ldreg(AES128_XK0 + 3));
+
+    for (int xk = AES128_XK0 + 4; xk < AES128_XK0 + 40; xk += 4)
+        do_round_xk(xk, 0);
+
+    do_round_xk(AES128_XK0 + 40, 1);
+}
+
 void aes128_encrypt(void)
 {
+    if (AES128_EXPANDED_KEY)
+    {
+        encrypt_xk();
+        return;
+    }
+
     uint32_t tmp;
     tmp = aes128_ldreg(AES128_K0);
     aes128_streg(AES128_RK0, tmp);
@@ -210,10 +316,7 @@ void aes128_encrypt(void)
         if (rcon == 0x36)
             break;
 
-        if (rcon == 0x80)
-            rcon = 0x1B;
-        else
-            rcon <<= 1;
+        rcon = next_rcon(rcon);
     }
 
     // clear round key
@@ -222,3 +325,63 @@ void aes128_encrypt(void)
     aes128_streg(AES128_RK2, 0);
     aes128_streg(AES128_RK3, 0);
 }
+
+
+void aes128_ctx_set_key(aes128_ctx_t *ctx, const uint8_t key[16])
+{
+    uint32_t w0 = u8to32le(&key[0]);
+    uint32_t w1 = u8to32le(&key[4]);
+    uint32_t w2 = u8to32le(&key[8]);
+    uint32_t w3 = u8to32le(&key[12]);
+
+    int rcon = 0x01;
+
+    for (int i = 0; ; i += 4)
+    {
+        ctx->rk[i + 0] = w0;
+        ctx->rk[i + 1] = w1;
+        ctx->rk[i + 2] = w2;
+        ctx->rk[i + 3] = w3;
+
+        if (i == 40)
+            break;
+
+        w0 ^= key_core(w3, rcon);
+        w1 ^= w0;
+        w2 ^= w1;
+        w3 ^= w2;
+
+        rcon = next_rcon(rcon);
+    }
+}
+
+void aes128_ctx_encrypt(const aes128_ctx_t *ctx, uint8_t block[16])
+{
+    const uint32_t *rk = ctx->rk;
+
+    uint32_t c0 = u8to32le(&block[0]) ^ rk[0];
+    uint32_t c1 = u8to32le(&block[4]) ^ rk[1];
+    uint32_t c2 = u8to32le(&block[8]) ^ rk[2];
+    uint32_t c3 = u8to32le(&block[12]) ^ rk[3];
+
+    for (int i = 4; i <= 40; i += 4)
+    {
+        sub_shift_mix(&c0, &c1, &c2, &c3, i == 40);
+
+        c0 ^= rk[i + 0];
+        c1 ^= rk[i + 1];
+        c2 ^= rk[i + 2];
+        c3 ^= rk[i + 3];
+    }
+
+    u32to8le(&block[0], c0);
+    u32to8le(&block[4], c1);
+    u32to8le(&block[8], c2);
+    u32to8le(&block[12], c3);
+}
+
+void aes128_ctx_clear(aes128_ctx_t *ctx)
+{
+    for (int i = 0; i < 44; i++)
+        ctx->rk[i] = 0;
+}
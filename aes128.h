@@ -1,6 +1,12 @@
 #ifndef _AES128_H_
 #define _AES128_H_
 
+// 1: keep the expanded key schedule (44 words) in store. The round keys are computed once by aes128_set_key.
+// 0: compute the round keys on the fly for each block. Slower, but the store is just 12 words.
+#ifndef AES128_EXPANDED_KEY
+#define AES128_EXPANDED_KEY 0
+#endif
+
 enum aes128_regs_e
 {
     // key
@@ -20,14 +26,24 @@ enum aes128_regs_e
     AES128_S1,
     AES128_S2,
     AES128_S3,
+
+    // expanded key, 11 round keys of 4 words. present in the expanded key mode only
+    AES128_XK0,
 };
 
-#define AES128_NREGS 12
+#define AES128_NREGS (AES128_EXPANDED_KEY ? AES128_XK0 + 44 : AES128_XK0)
+
+// re-entrant instance, the alternative to the singleton store
+typedef struct
+{
+    uint32_t rk[44];    // expanded key
+} aes128_ctx_t;
 
 extern void aes128_streg(int i, uint32_t w);
 extern uint32_t aes128_ldreg(int i);
 
 void aes128_set_key(const uint8_t key[16]);
+void aes128_expand_key(void);
 void aes128_set_data(const uint8_t src[16]);
 void aes128_get_data(uint8_t dst[16]);
 
@@ -36,4 +52,8 @@ void aes128_clear_data(void);
 
 void aes128_encrypt(void);
 
+void aes128_ctx_set_key(aes128_ctx_t *ctx, const uint8_t key[16]);
+void aes128_ctx_encrypt(const aes128_ctx_t *ctx, uint8_t block[16]);
+void aes128_ctx_clear(aes128_ctx_t *ctx);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,423 @@
+/*
+   Bitsliced AES-128, 8 blocks per run.
+
+   The state of 8 blocks is 8 bit planes (bit b of every byte) of 128 bits.
+   The plane is kept in two 64-bit words in the byte order of the block: q[0][b] is bytes 0 - 7 (columns 0, 1),
+   q[1][b] is bytes 8 - 15 (columns 2, 3). The bit j of each byte is the block j.
+
+   With this layout:
+    The blocks are converted to/from the planes by the 8x8 bit transposes between the words (ortho).
+    SubBytes is the boolean circuit over planes (Boyar-Peralta, 113 gates), 64 bytes per run.
+    ShiftRows is the byte shuffle between the two words.
+    MixColumns works on the whole columns (32-bit halves), the xtime is just a plane renaming plus xors.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "aes128bs.h"
+
+static void sbox(uint64_t *q)
+{
+    uint64_t x0 = q[7];
+    uint64_t x1 = q[6];
+    uint64_t x2 = q[5];
+    uint64_t x3 = q[4];
+    uint64_t x4 = q[3];
+    uint64_t x5 = q[2];
+    uint64_t x6 = q[1];
+    uint64_t x7 = q[0];
+    uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    // top linear transform
+    uint64_t y14 = x3 ^ x5;
+    uint64_t y13 = x0 ^ x6;
+    uint64_t y9 = x0 ^ x3;
+    uint64_t y8 = x0 ^ x5;
+    uint64_t t0 = x1 ^ x2;
+    uint64_t y1 = t0 ^ x7;
+    uint64_t y4 = y1 ^ x3;
+    uint64_t y12 = y13 ^ y14;
+    uint64_t y2 = y1 ^ x0;
+    uint64_t y5 = y1 ^ x6;
+    uint64_t y3 = y5 ^ y8;
+    uint64_t t1 = x4 ^ y12;
+    uint64_t y15 = t1 ^ x5;
+    uint64_t y20 = t1 ^ x1;
+    uint64_t y6 = y15 ^ x7;
+    uint64_t y10 = y15 ^ t0;
+    uint64_t y11 = y20 ^ y9;
+    uint64_t y7 = x7 ^ y11;
+    uint64_t y17 = y10 ^ y11;
+    uint64_t y19 = y10 ^ y8;
+    uint64_t y16 = t0 ^ y11;
+    uint64_t y21 = y13 ^ y16;
+    uint64_t y18 = x0 ^ y16;
+
+    // nonlinear section
+    uint64_t t2 = y12 & y15;
+    uint64_t t3 = y3 & y6;
+    uint64_t t4 = t3 ^ t2;
+    uint64_t t5 = y4 & x7;
+    uint64_t t6 = t5 ^ t2;
+    uint64_t t7 = y13 & y16;
+    uint64_t t8 = y5 & y1;
+    uint64_t t9 = t8 ^ t7;
+    uint64_t t10 = y2 & y7;
+    uint64_t t11 = t10 ^ t7;
+    uint64_t t12 = y9 & y11;
+    uint64_t t13 = y14 & y17;
+    uint64_t t14 = t13 ^ t12;
+    uint64_t t15 = y8 & y10;
+    uint64_t t16 = t15 ^ t12;
+    uint64_t t17 = t4 ^ t14;
+    uint64_t t18 = t6 ^ t16;
+    uint64_t t19 = t9 ^ t14;
+    uint64_t t20 = t11 ^ t16;
+    uint64_t t21 = t17 ^ y20;
+    uint64_t t22 = t18 ^ y19;
+    uint64_t t23 = t19 ^ y21;
+    uint64_t t24 = t20 ^ y18;
+    uint64_t t25 = t21 ^ t22;
+    uint64_t t26 = t21 & t23;
+    uint64_t t27 = t24 ^ t26;
+    uint64_t t28 = t25 & t27;
+    uint64_t t29 = t28 ^ t22;
+    uint64_t t30 = t23 ^ t24;
+    uint64_t t31 = t22 ^ t26;
+    uint64_t t32 = t31 & t30;
+    uint64_t t33 = t32 ^ t24;
+    uint64_t t34 = t23 ^ t33;
+    uint64_t t35 = t27 ^ t33;
+    uint64_t t36 = t24 & t35;
+    uint64_t t37 = t36 ^ t34;
+    uint64_t t38 = t27 ^ t36;
+    uint64_t t39 = t29 & t38;
+    uint64_t t40 = t25 ^ t39;
+    uint64_t t41 = t40 ^ t37;
+    uint64_t t42 = t29 ^ t33;
+    uint64_t t43 = t29 ^ t40;
+    uint64_t t44 = t33 ^ t37;
+    uint64_t t45 = t42 ^ t41;
+    uint64_t z0 = t44 & y15;
+    uint64_t z1 = t37 & y6;
+    uint64_t z2 = t33 & x7;
+    uint64_t z3 = t43 & y16;
+    uint64_t z4 = t40 & y1;
+    uint64_t z5 = t29 & y7;
+    uint64_t z6 = t42 & y11;
+    uint64_t z7 = t45 & y17;
+    uint64_t z8 = t41 & y10;
+    uint64_t z9 = t44 & y12;
+    uint64_t z10 = t37 & y3;
+    uint64_t z11 = t33 & y4;
+    uint64_t z12 = t43 & y13;
+    uint64_t z13 = t40 & y5;
+    uint64_t z14 = t29 & y2;
+    uint64_t z15 = t42 & y9;
+    uint64_t z16 = t45 & y14;
+    uint64_t z17 = t41 & y8;
+
+    // bottom linear transform
+    uint64_t t46 = z15 ^ z16;
+    uint64_t t47 = z10 ^ z11;
+    uint64_t t48 = z5 ^ z13;
+    uint64_t t49 = z9 ^ z10;
+    uint64_t t50 = z2 ^ z12;
+    uint64_t t51 = z2 ^ z5;
+    uint64_t t52 = z7 ^ z8;
+    uint64_t t53 = z0 ^ z3;
+    uint64_t t54 = z6 ^ z7;
+    uint64_t t55 = z16 ^ z17;
+    uint64_t t56 = z12 ^ t48;
+    uint64_t t57 = t50 ^ t53;
+    uint64_t t58 = z4 ^ t46;
+    uint64_t t59 = z3 ^ t54;
+    uint64_t t60 = t46 ^ t57;
+    uint64_t t61 = z14 ^ t57;
+    uint64_t t62 = t52 ^ t58;
+    uint64_t t63 = t49 ^ t58;
+    uint64_t t64 = z4 ^ t59;
+    uint64_t t65 = t61 ^ t62;
+    uint64_t t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    uint64_t t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+// bit j of byte o of word m <-> bit m of byte o of word j, i.e. 8x8 bit transposes between the words
+#define SWAPN(cl, ch, s, x, y) \
+    do \
+    { \
+        uint64_t a = x; \
+        uint64_t b = y; \
+        x = (a & (uint64_t)cl) | ((b & (uint64_t)cl) << (s)); \
+        y = ((a & (uint64_t)ch) >> (s)) | (b & (uint64_t)ch); \
+    } while (0)
+
+#define SWAP2(x, y)   SWAPN(0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 1, x, y)
+#define SWAP4(x, y)   SWAPN(0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2, x, y)
+#define SWAP8(x, y)   SWAPN(0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL, 4, x, y)
+
+static inline void ortho(uint64_t *q)
+{
+    SWAP2(q[0], q[1]);
+    SWAP2(q[2], q[3]);
+    SWAP2(q[4], q[5]);
+    SWAP2(q[6], q[7]);
+
+    SWAP4(q[0], q[2]);
+    SWAP4(q[1], q[3]);
+    SWAP4(q[4], q[6]);
+    SWAP4(q[5], q[7]);
+
+    SWAP8(q[0], q[4]);
+    SWAP8(q[1], q[5]);
+    SWAP8(q[2], q[6]);
+    SWAP8(q[3], q[7]);
+}
+
+static inline uint64_t u8to64le(const uint8_t *b)
+{
+    uint64_t w = 0;
+    for (int i = 7; i >= 0; i--)
+        w = (w << 8) | b[i];
+    return w;
+}
+
+static inline void u64to8le(uint8_t *b, uint64_t w)
+{
+    for (int i = 0; i < 8; i++)
+        b[i] = w >> (i * 8);
+}
+
+// word j of the half h is bytes 8h .. 8h + 7 of block j. the ortho turns it into the bit planes
+static void load_blocks(uint64_t q[2][8], const uint8_t *blocks)
+{
+    for (int h = 0; h < 2; h++)
+    {
+        for (int j = 0; j < 8; j++)
+            q[h][j] = u8to64le(&blocks[j * 16 + h * 8]);
+
+        ortho(q[h]);
+    }
+}
+
+static void store_blocks(uint8_t *blocks, uint64_t q[2][8])
+{
+    for (int h = 0; h < 2; h++)
+    {
+        ortho(q[h]);
+
+        for (int j = 0; j < 8; j++)
+            u64to8le(&blocks[j * 16 + h * 8], q[h][j]);
+    }
+}
+
+static inline void add_round_key(uint64_t q[2][8], const uint64_t sk[2][8])
+{
+    for (int b = 0; b < 8; b++)
+    {
+        q[0][b] ^= sk[0][b];
+        q[1][b] ^= sk[1][b];
+    }
+}
+
+static inline void sub_bytes(uint64_t q[2][8])
+{
+    sbox(q[0]);
+    sbox(q[1]);
+}
+
+// rotate right each of the 32-bit halves by n bits
+static inline uint64_t rotr_halves(uint64_t w, int n)
+{
+    uint64_t m = (uint64_t)(0xFFFFFFFFU >> n) * 0x100000001ULL;
+    return ((w >> n) & m) | ((w << (32 - n)) & ~m);
+}
+
+static inline void shift_rows(uint64_t q[2][8])
+{
+    // byte masks of the row r in both columns of word
+    const uint64_t r0 = 0x000000FF000000FFULL;
+    const uint64_t r2 = r0 << 16;
+    const uint64_t r1lo = 0x000000000000FF00ULL;
+    const uint64_t r1hi = r1lo << 32;
+    const uint64_t r3lo = 0x00000000FF000000ULL;
+    const uint64_t r3hi = r3lo << 32;
+
+    for (int b = 0; b < 8; b++)
+    {
+        uint64_t w0 = q[0][b];
+        uint64_t w1 = q[1][b];
+
+        // row r is rotated left by r columns. the columns are 0, 1 in w0 and 2, 3 in w1
+        q[0][b] = (w0 & r0) | ((w0 >> 32) & r1lo) | ((w1 << 32) & r1hi) | (w1 & r2) | ((w1 >> 32) & r3lo) | ((w0 << 32) & r3hi);
+        q[1][b] = (w1 & r0) | ((w1 >> 32) & r1lo) | ((w0 << 32) & r1hi) | (w0 & r2) | ((w0 >> 32) & r3lo) | ((w1 << 32) & r3hi);
+    }
+}
+
+static inline void mix_columns(uint64_t q[2][8])
+{
+    for (int h = 0; h < 2; h++)
+    {
+        uint64_t t[8];
+
+        // out_r = 2 * (a_r ^ a_r+1) ^ a_r+1 ^ a_r+2 ^ a_r+3. the column is the 32-bit half
+        for (int b = 0; b < 8; b++)
+        {
+            uint64_t w = q[h][b];
+            uint64_t a1 = rotr_halves(w, 8);
+
+            t[b] = w ^ a1;
+            q[h][b] = a1 ^ rotr_halves(w, 16) ^ rotr_halves(w, 24);
+        }
+
+        // xtime on planes, x^8 = x^4 + x^3 + x + 1
+        uint64_t hb = t[7];
+
+        q[h][0] ^= hb;
+        q[h][1] ^= t[0] ^ hb;
+        q[h][2] ^= t[1];
+        q[h][3] ^= t[2] ^ hb;
+        q[h][4] ^= t[3] ^ hb;
+        q[h][5] ^= t[4];
+        q[h][6] ^= t[5];
+        q[h][7] ^= t[6];
+    }
+}
+
+static void encrypt8(const aes128bs_ctx_t *ctx, uint8_t *blocks)
+{
+    uint64_t q[2][8];
+
+    load_blocks(q, blocks);
+
+    add_round_key(q, ctx->sk[0]);
+
+    for (int r = 1; r < 10; r++)
+    {
+        sub_bytes(q);
+        shift_rows(q);
+        mix_columns(q);
+        add_round_key(q, ctx->sk[r]);
+    }
+
+    sub_bytes(q);
+    shift_rows(q);
+    add_round_key(q, ctx->sk[10]);
+
+    store_blocks(blocks, q);
+
+    memset(q, 0, sizeof(q));
+}
+
+// SubWord via the same circuit, the bit k of plane b is the bit b of byte k
+static uint32_t sub_word(uint32_t w)
+{
+    uint64_t q[8];
+
+    for (int b = 0; b < 8; b++)
+    {
+        q[b] = 0;
+        for (int k = 0; k < 4; k++)
+            q[b] |= (uint64_t)((w >> (k * 8 + b)) & 1) << k;
+    }
+
+    sbox(q);
+
+    w = 0;
+    for (int b = 0; b < 8; b++)
+    {
+        for (int k = 0; k < 4; k++)
+            w |= (uint32_t)((q[b] >> k) & 1) << (k * 8 + b);
+    }
+
+    return w;
+}
+
+void aes128bs_set_key(aes128bs_ctx_t *ctx, const uint8_t key[16])
+{
+    uint32_t rk[44];
+    int rcon = 0x01;
+
+    for (int i = 0; i < 4; i++)
+        rk[i] = key[i * 4] | (key[i * 4 + 1] << 8) | (key[i * 4 + 2] << 16) | ((uint32_t)key[i * 4 + 3] << 24);
+
+    for (int i = 4; i < 44; i++)
+    {
+        uint32_t tmp = rk[i - 1];
+
+        if (i % 4 == 0)
+        {
+            tmp = sub_word((tmp >> 8) | (tmp << 24)) ^ rcon;
+            rcon = (rcon << 1) ^ ((rcon >> 7) * 0x11B);
+        }
+
+        rk[i] = rk[i - 4] ^ tmp;
+    }
+
+    // the round key byte is the same for all the blocks, so its bit becomes the all-ones or zero byte in plane
+    for (int r = 0; r < 11; r++)
+    {
+        for (int b = 0; b < 8; b++)
+        {
+            ctx->sk[r][0][b] = 0;
+            ctx->sk[r][1][b] = 0;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            uint64_t bits = (rk[r * 4 + i / 4] >> ((i % 4) * 8)) & 0xFF;
+
+            for (int b = 0; b < 8; b++)
+                ctx->sk[r][i / 8][b] |= (((bits >> b) & 1) * 0xFF) << ((i % 8) * 8);
+        }
+    }
+
+    memset(rk, 0, sizeof(rk));
+}
+
+void aes128bs_encrypt_blocks(const aes128bs_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    while (n >= 8)
+    {
+        encrypt8(ctx, blocks);
+        blocks += 8 * 16;
+        n -= 8;
+    }
+
+    if (n)
+    {
+        uint8_t tmp[8 * 16] = {0};
+
+        memcpy(tmp, blocks, n * 16);
+        encrypt8(ctx, tmp);
+        memcpy(blocks, tmp, n * 16);
+        memset(tmp, 0, sizeof(tmp));
+    }
+}
+
+void aes128bs_encrypt(const aes128bs_ctx_t *ctx, uint8_t block[16])
+{
+    aes128bs_encrypt_blocks(ctx, block, 1);
+}
+
+void aes128bs_clear(aes128bs_ctx_t *ctx)
+{
+    memset(ctx, 0, sizeof(aes128bs_ctx_t));
+}
@@ -0,0 +1,32 @@
+#ifndef _AES128BS_H_
+#define _AES128BS_H_
+
+/*
+    Bitsliced constant-time AES-128.
+
+    The 8 blocks are processed at once using the 64-bit logic ops only, no tables and no
+    secret-dependent branches or memory accesses (key schedule included).
+
+    The flow is:
+     1) aes128bs_set_key(ctx, key)
+     2) aes128bs_encrypt_blocks(ctx, blocks, n)
+     3) aes128bs_clear(ctx)
+
+    Any n is fine, but the work is done in groups of 8, so the batches of multiple of 8 blocks are the most efficient.
+    The single block aes128bs_encrypt costs as much as 8 blocks, it's here for the serial OMAC chains.
+
+    The context holds the bitsliced round keys only and is read-only while encrypting,
+    so the single context may be shared by threads.
+*/
+
+typedef struct
+{
+    uint64_t sk[11][2][8];  // bitsliced round keys: round, row pair, bit plane
+} aes128bs_ctx_t;
+
+void aes128bs_set_key(aes128bs_ctx_t *ctx, const uint8_t key[16]);
+void aes128bs_encrypt(const aes128bs_ctx_t *ctx, uint8_t block[16]);
+void aes128bs_encrypt_blocks(const aes128bs_ctx_t *ctx, uint8_t *blocks, unsigned int n);
+void aes128bs_clear(aes128bs_ctx_t *ctx);
+
+#endif
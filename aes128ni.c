@@ -0,0 +1,117 @@
+#include <stdint.h>
+#include <string.h>
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#include "aes128ni.h"
+
+#define AESNI   __attribute__((target("aes,sse2")))
+
+int aes128ni_supported(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (ecx & bit_AES) != 0;
+}
+
+AESNI static inline __m128i expand_step(__m128i k, __m128i kga)
+{
+    kga = _mm_shuffle_epi32(kga, 0xFF);
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    return _mm_xor_si128(k, kga);
+}
+
+// rcon must be the immediate, hence the macro
+#define EXPAND(i, rcon) \
+    k = expand_step(k, _mm_aeskeygenassist_si128(k, rcon)); \
+    _mm_storeu_si128((__m128i *)ctx->rk[i], k)
+
+AESNI void aes128ni_set_key(aes128ni_ctx_t *ctx, const uint8_t key[16])
+{
+    __m128i k = _mm_loadu_si128((const __m128i *)key);
+    _mm_storeu_si128((__m128i *)ctx->rk[0], k);
+
+    EXPAND(1, 0x01);
+    EXPAND(2, 0x02);
+    EXPAND(3, 0x04);
+    EXPAND(4, 0x08);
+    EXPAND(5, 0x10);
+    EXPAND(6, 0x20);
+    EXPAND(7, 0x40);
+    EXPAND(8, 0x80);
+    EXPAND(9, 0x1B);
+    EXPAND(10, 0x36);
+}
+
+#undef EXPAND
+
+AESNI void aes128ni_encrypt(const aes128ni_ctx_t *ctx, uint8_t block[16])
+{
+    __m128i b = _mm_loadu_si128((const __m128i *)block);
+
+    b = _mm_xor_si128(b, _mm_loadu_si128((const __m128i *)ctx->rk[0]));
+    for (int i = 1; i < 10; i++)
+        b = _mm_aesenc_si128(b, _mm_loadu_si128((const __m128i *)ctx->rk[i]));
+    b = _mm_aesenclast_si128(b, _mm_loadu_si128((const __m128i *)ctx->rk[10]));
+
+    _mm_storeu_si128((__m128i *)block, b);
+}
+
+AESNI void aes128ni_encrypt_blocks(const aes128ni_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    __m128i *p = (__m128i *)blocks;
+
+    while (n >= 8)
+    {
+        __m128i rk = _mm_loadu_si128((const __m128i *)ctx->rk[0]);
+
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(p + 0), rk);
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(p + 1), rk);
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(p + 2), rk);
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(p + 3), rk);
+        __m128i b4 = _mm_xor_si128(_mm_loadu_si128(p + 4), rk);
+        __m128i b5 = _mm_xor_si128(_mm_loadu_si128(p + 5), rk);
+        __m128i b6 = _mm_xor_si128(_mm_loadu_si128(p + 6), rk);
+        __m128i b7 = _mm_xor_si128(_mm_loadu_si128(p + 7), rk);
+
+        // the 8 independent aesenc are issued back to back, so the pipeline is kept busy
+        for (int i = 1; i < 10; i++)
+        {
+            rk = _mm_loadu_si128((const __m128i *)ctx->rk[i]);
+            b0 = _mm_aesenc_si128(b0, rk);
+            b1 = _mm_aesenc_si128(b1, rk);
+            b2 = _mm_aesenc_si128(b2, rk);
+            b3 = _mm_aesenc_si128(b3, rk);
+            b4 = _mm_aesenc_si128(b4, rk);
+            b5 = _mm_aesenc_si128(b5, rk);
+            b6 = _mm_aesenc_si128(b6, rk);
+            b7 = _mm_aesenc_si128(b7, rk);
+        }
+
+        rk = _mm_loadu_si128((const __m128i *)ctx->rk[10]);
+        _mm_storeu_si128(p + 0, _mm_aesenclast_si128(b0, rk));
+        _mm_storeu_si128(p + 1, _mm_aesenclast_si128(b1, rk));
+        _mm_storeu_si128(p + 2, _mm_aesenclast_si128(b2, rk));
+        _mm_storeu_si128(p + 3, _mm_aesenclast_si128(b3, rk));
+        _mm_storeu_si128(p + 4, _mm_aesenclast_si128(b4, rk));
+        _mm_storeu_si128(p + 5, _mm_aesenclast_si128(b5, rk));
+        _mm_storeu_si128(p + 6, _mm_aesenclast_si128(b6, rk));
+        _mm_storeu_si128(p + 7, _mm_aesenclast_si128(b7, rk));
+
+        p += 8;
+        n -= 8;
+    }
+
+    while (n--)
+        aes128ni_encrypt(ctx, (uint8_t *)p++);
+}
+
+void aes128ni_clear(aes128ni_ctx_t *ctx)
+{
+    memset(ctx, 0, sizeof(aes128ni_ctx_t));
+}
@@ -0,0 +1,34 @@
+#ifndef _AES128NI_H_
+#define _AES128NI_H_
+
+/*
+    AES-128 via the x86 AES-NI instructions.
+
+    The flow is:
+     1) check aes128ni_supported()
+     2) aes128ni_set_key(ctx, key)
+     3) aes128ni_encrypt(ctx, block) or aes128ni_encrypt_blocks(ctx, blocks, n)
+     4) aes128ni_clear(ctx)
+
+    The context holds the expanded key only and is read-only while encrypting,
+    so the single context may be shared by threads.
+
+    aes128ni_encrypt_blocks keeps 8 independent blocks in flight to hide the AESENC latency.
+    It's the one to use for the CTR keystream and other batches.
+
+    x86 only. The code is compiled with the target attributes, so no special compiler flags are required.
+*/
+
+typedef struct
+{
+    uint8_t rk[11][16];     // expanded key
+} aes128ni_ctx_t;
+
+int aes128ni_supported(void);
+
+void aes128ni_set_key(aes128ni_ctx_t *ctx, const uint8_t key[16]);
+void aes128ni_encrypt(const aes128ni_ctx_t *ctx, uint8_t block[16]);
+void aes128ni_encrypt_blocks(const aes128ni_ctx_t *ctx, uint8_t *blocks, unsigned int n);
+void aes128ni_clear(aes128ni_ctx_t *ctx);
+
+#endif
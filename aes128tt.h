@@ -0,0 +1,33 @@
+#ifndef _AES128TT_H_
+#define _AES128TT_H_
+
+/*
+    Classic T-table AES-128, the fast portable one.
+
+    The round is the 16 lookups into the four 1KB tables (SubBytes, ShiftRows and MixColumns merged) plus xors.
+    The key schedule is expanded once per key.
+
+    The flow is:
+     1) aes128tt_set_key(ctx, key)
+     2) aes128tt_encrypt(ctx, block) or aes128tt_encrypt_blocks(ctx, blocks, n)
+     3) aes128tt_clear(ctx)
+
+    WARNING: the table lookups are indexed by the secret data, so the timing depends on the cache state.
+    Use it only where the cache-timing side channels are not a concern (or are handled elsewhere).
+    Otherwise use aes128 (no tables at all), aes128bs (bitsliced) or aes128ni.
+
+    The context holds the expanded key only and is read-only while encrypting,
+    so the single context may be shared by threads.
+*/
+
+typedef struct
+{
+    uint32_t rk[44];    // expanded key
+} aes128tt_ctx_t;
+
+void aes128tt_set_key(aes128tt_ctx_t *ctx, const uint8_t key[16]);
+void aes128tt_encrypt(const aes128tt_ctx_t *ctx, uint8_t block[16]);
+void aes128tt_encrypt_blocks(const aes128tt_ctx_t *ctx, uint8_t *blocks, unsigned int n);
+void aes128tt_clear(aes128tt_ctx_t *ctx);
+
+#endif
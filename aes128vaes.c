@@ -0,0 +1,86 @@
+#include <stdint.h>
+#include <cpuid.h>
+#include <immintrin.h>
+#include "aes128vaes.h"
+
+#define VAES    __attribute__((target("vaes,avx512f,aes,sse2")))
+
+// xgetbv without the xsave target
+static uint64_t xcr0(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+int aes128vaes_supported(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    if (!(ecx & bit_AES) || !(ecx & bit_OSXSAVE))
+        return 0;
+
+    // the OS must save the sse, avx and all the avx-512 state
+    if ((xcr0() & 0xE6) != 0xE6)
+        return 0;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (ebx & bit_AVX512F) && (ecx & bit_VAES);
+}
+
+// round key i in all 4 lanes
+#define RK(i) _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)ctx->rk[i]))
+
+VAES void aes128vaes_encrypt_blocks(const aes128ni_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    __m512i *p = (__m512i *)blocks;
+
+    while (n >= 16)
+    {
+        __m512i rk = RK(0);
+
+        __m512i b0 = _mm512_xor_si512(_mm512_loadu_si512(p + 0), rk);
+        __m512i b1 = _mm512_xor_si512(_mm512_loadu_si512(p + 1), rk);
+        __m512i b2 = _mm512_xor_si512(_mm512_loadu_si512(p + 2), rk);
+        __m512i b3 = _mm512_xor_si512(_mm512_loadu_si512(p + 3), rk);
+
+        for (int i = 1; i < 10; i++)
+        {
+            rk = RK(i);
+            b0 = _mm512_aesenc_epi128(b0, rk);
+            b1 = _mm512_aesenc_epi128(b1, rk);
+            b2 = _mm512_aesenc_epi128(b2, rk);
+            b3 = _mm512_aesenc_epi128(b3, rk);
+        }
+
+        rk = RK(10);
+        _mm512_storeu_si512(p + 0, _mm512_aesenclast_epi128(b0, rk));
+        _mm512_storeu_si512(p + 1, _mm512_aesenclast_epi128(b1, rk));
+        _mm512_storeu_si512(p + 2, _mm512_aesenclast_epi128(b2, rk));
+        _mm512_storeu_si512(p + 3, _mm512_aesenclast_epi128(b3, rk));
+
+        p += 4;
+        n -= 16;
+    }
+
+    while (n >= 4)
+    {
+        __m512i b = _mm512_xor_si512(_mm512_loadu_si512(p), RK(0));
+
+        for (int i = 1; i < 10; i++)
+            b = _mm512_aesenc_epi128(b, RK(i));
+
+        _mm512_storeu_si512(p, _mm512_aesenclast_epi128(b, RK(10)));
+
+        p++;
+        n -= 4;
+    }
+
+    if (n)
+        aes128ni_encrypt_blocks(ctx, (uint8_t *)p, n);
+}
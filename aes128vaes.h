@@ -0,0 +1,30 @@
+#ifndef _AES128VAES_H_
+#define _AES128VAES_H_
+
+#include "aes128ni.h"
+
+/*
+    AES-128 via the VAES instructions on the 512-bit registers (Ice Lake and later).
+
+    Each AESENC works on 4 blocks, and the 4 registers are kept in flight, so 16 blocks go per round.
+    It's the multi-block backend only. The key schedule and the single block encryption are the AES-NI ones,
+    so the context is the aes128ni_ctx_t.
+
+    The flow is:
+     1) check aes128vaes_supported(). If it fails, use aes128ni_encrypt_blocks (if aes128ni_supported())
+        or the portable code with the same binary
+     2) aes128ni_set_key(ctx, key)
+     3) aes128vaes_encrypt_blocks(ctx, blocks, n)
+     4) aes128ni_clear(ctx)
+
+    Batches of multiple of 16 blocks are the most efficient. Build eax128.c with CTR_BATCH=16 and BATCH_LANES=16
+    to feed it with the full batches.
+
+    x86 only. The code is compiled with the target attributes, so no special compiler flags are required.
+*/
+
+int aes128vaes_supported(void);
+
+void aes128vaes_encrypt_blocks(const aes128ni_ctx_t *ctx, uint8_t *blocks, unsigned int n);
+
+#endif
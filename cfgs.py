@@ -1,5 +1,6 @@
 import struct
 import xtea
+import speck
 
 try:
     from Crypto.Cipher import AES
@@ -28,3 +29,15 @@ class XTEACfg:
             self.enc  = xtea.XTEA(key)
         def run(self, pt):
             return self.enc.encrypt(pt)
+
+class SpeckCfg:
+
+    BLOCKSIZE = 8
+    BLOCKSIZE_MASK = (1 << 64) - 1
+    ENDIAN = 'little'
+
+    class ECB:
+        def __init__(self, key):
+            self.enc  = speck.Speck64(key)
+        def run(self, pt):
+            return self.enc.encrypt(pt)
@@ -0,0 +1,46 @@
+#include <stdint.h>
+#include <cpuid.h>
+#include "cpux86.h"
+
+// xgetbv without the xsave target
+static uint64_t xcr0(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static int probe_avx2(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    if (!(ecx & bit_AVX) || !(ecx & bit_OSXSAVE))
+        return 0;
+
+    // the OS must save the sse and avx state
+    if ((xcr0() & 0x6) != 0x6)
+        return 0;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (ebx & bit_AVX2) != 0;
+}
+
+int cpux86_avx2_supported(void)
+{
+    // -1 until probed. the concurrent first calls all store the same value, the atomics keep it race-free
+    static int avx2 = -1;
+    int r = __atomic_load_n(&avx2, __ATOMIC_RELAXED);
+
+    if (r < 0)
+    {
+        r = probe_avx2();
+        __atomic_store_n(&avx2, r, __ATOMIC_RELAXED);
+    }
+
+    return r;
+}
@@ -0,0 +1,15 @@
+#ifndef _CPUX86_H_
+#define _CPUX86_H_
+
+/*
+    The x86 cpu feature probes shared by the vector ciphers.
+
+    cpux86_avx2_supported() checks the cpu flags and that the OS saves the ymm state.
+    The result is probed once and cached, it's safe to call from the multiple threads.
+
+    x86 only.
+*/
+
+int cpux86_avx2_supported(void);
+
+#endif
@@ -5,14 +5,40 @@
 #define BIG_CTR     1
 #define BIG_TAIL    1
 
+#ifndef USE_CUSTOM_MATH128
 #define USE_CUSTOM_MATH128 0    // use user-coded 128bit math (assembly or something)
+#endif
 
-extern void _add128be_32le(uint32_t dst[4], const uint32_t a[4], uint32_t inc);
-extern void _add128le_32le(uint32_t dst[4], const uint32_t a[4], uint32_t inc);
+#ifndef USE_CIPHER_BLOCKS
+#define USE_CIPHER_BLOCKS 0     // use the user-provided multi-block cipher (pipelined, SIMD, etc)
+#endif
+
+#ifndef CTR_BATCH
+#define CTR_BATCH   8           // max blocks per multi-block cipher call
+#endif
+
+#ifndef BATCH_LANES
+#define BATCH_LANES 8           // messages processed in lockstep by eax128_verify_batch
+#endif
+
+extern void _add128be_64le(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+extern void _add128le_64le(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
 extern void _gf_double_128be(uint32_t dst[4], const uint32_t src[4], int n);
 extern void _gf_double_128le(uint32_t dst[4], const uint32_t src[4], int n);
 extern void _xor128(uint32_t dst[4], const uint32_t a[4], const uint32_t b[4]);
 
+static void cipher_blocks(void *cipher_ctx, eax128_block_t *blocks, unsigned int n)
+{
+    if (USE_CIPHER_BLOCKS)
+    {
+        eax128_cipher_blocks(cipher_ctx, blocks->b, n);
+        return;
+    }
+
+    for (unsigned int i = 0; i < n; i++)
+        eax128_cipher(cipher_ctx, blocks[i].b);
+}
+
 static uint64_t byterev64(uint64_t a)
 {
     return    (((a >>  0) & 0xff) << 56)
@@ -49,11 +75,11 @@ static void gf_double(eax128_block_t *dst, eax128_block_t *src, int n)
 }
 
 
-static void add_ctr(eax128_block_t *dst, const eax128_block_t *a, uint32_t inc)
+static void add_ctr(eax128_block_t *dst, const eax128_block_t *a, uint64_t inc)
 {
     if (USE_CUSTOM_MATH128)
     {
-        BIG_CTR ? _add128be_32le(dst->w, a->w, inc) : _add128le_32le(dst->w, a->w, inc);
+        BIG_CTR ? _add128be_64le(dst->w, a->w, inc) : _add128le_64le(dst->w, a->w, inc);
         return;
     }
 
@@ -62,7 +88,7 @@ static void add_ctr(eax128_block_t *dst, const eax128_block_t *a, uint32_t inc)
 
     q0 += inc;
 
-    if (q0 < (uint64_t)inc)
+    if (q0 < inc)
         q1 += 1;
 
     dst->q[0] = BIG_CTR ? byterev64(q1) : q0;
@@ -83,46 +109,107 @@ static void xor128(eax128_block_t *dst, const eax128_block_t *a, const eax128_bl
 }
 
 
-void eax128_omac_init(eax128_omac_t *ctx, void *cipher_ctx, int k)
+void eax128_key_init(eax128_key_t *key, void *cipher_ctx)
+{
+    memset(key, 0, sizeof(eax128_key_t));
+    key->cipher_ctx = cipher_ctx;
+
+    // L = E(0)
+    eax128_cipher(cipher_ctx, key->l2.b);
+    gf_double(&key->l2, &key->l2, 1);
+    gf_double(&key->l4, &key->l2, 1);
+
+    // the tweak block is always the first one, so the omac state after it depends on key only.
+    // for the empty data it's the last one too
+    eax128_block_t pre[6] = {{{0}}};
+
+    for (int k = 0; k < 3; k++)
+    {
+        pre[k].b[15] = k;
+        xor128(&pre[3 + k], &pre[k], &key->l2);
+    }
+
+    // all six in a single batch
+    cipher_blocks(cipher_ctx, pre, 6);
+
+    memcpy(key->tweak, &pre[0], sizeof(key->tweak));
+    memcpy(key->empty, &pre[3], sizeof(key->empty));
+    memset(pre, 0, sizeof(pre));
+}
+
+void eax128_key_clear(eax128_key_t *key)
+{
+    memset(key, 0, sizeof(eax128_key_t));
+}
+
+
+void eax128_omac_init(eax128_omac_t *ctx, const eax128_key_t *key, int k)
 {
     memset(ctx, 0, sizeof(eax128_omac_t));
-    ctx->block.b[15] = k;
-    ctx->cipher_ctx = cipher_ctx;
+    ctx->mac = key->tweak[k];     // tweak block is already processed
+    ctx->k = k;
+    ctx->key = key;
 }
 
 void eax128_omac_process(eax128_omac_t *ctx, int byte)
 {
-    // got full block here, convert it
-    if (ctx->bytepos == 0)
+    // got full block here and more data is coming, convert it
+    if (ctx->bytepos == 16)
     {
         xor128(&ctx->mac, &ctx->mac, &ctx->block);
-        eax128_cipher(ctx->cipher_ctx, ctx->mac.b);
+        eax128_cipher(ctx->key->cipher_ctx, ctx->mac.b);
         ctx->block.q[0] = 0;
         ctx->block.q[1] = 0;
+        ctx->bytepos = 0;
     }
 
-    ctx->block.b[ctx->bytepos] = byte;
-    ctx->bytepos = (ctx->bytepos + 1) & 15;
+    ctx->block.b[ctx->bytepos++] = byte;
 }
 
 eax128_block_t *eax128_omac_digest(eax128_omac_t *ctx)
 {
-    if (ctx->bytepos != 0)
+    // no data, the result is precomputed
+    if (ctx->bytepos == 0)
+    {
+        ctx->mac = ctx->key->empty[ctx->k];
+        return &ctx->mac;
+    }
+
+    if (ctx->bytepos != 16)
         ctx->block.b[ctx->bytepos] = 0x80;
 
     xor128(&ctx->mac, &ctx->mac, &ctx->block);
+    xor128(&ctx->mac, &ctx->mac, ctx->bytepos == 16 ? &ctx->key->l2 : &ctx->key->l4);
+    eax128_cipher(ctx->key->cipher_ctx, ctx->mac.b);
 
-    // now block is no longer needed, reuse it as tail
-    eax128_block_t *tail = &ctx->block;
-    tail->q[0] = 0;
-    tail->q[1] = 0;
-    eax128_cipher(ctx->cipher_ctx, tail->b);
-    gf_double(tail, tail, ctx->bytepos == 0 ? 1 : 2);
+    return &ctx->mac;
+}
+
+void eax128_omac_process_buf(eax128_omac_t *ctx, const uint8_t *data, size_t len)
+{
+    // complete the partial block byte-by-byte
+    while (len && (ctx->bytepos % 16) != 0)
+    {
+        eax128_omac_process(ctx, *data++);
+        len--;
+    }
 
-    xor128(&ctx->mac, &ctx->mac, tail);
-    eax128_cipher(ctx->cipher_ctx, ctx->mac.b);
+    // the pending block is either empty or full here. absorb it and take the next one as a whole
+    while (len >= 16)
+    {
+        if (ctx->bytepos == 16)
+        {
+            xor128(&ctx->mac, &ctx->mac, &ctx->block);
+            eax128_cipher(ctx->key->cipher_ctx, ctx->mac.b);
+        }
+        memcpy(ctx->block.b, data, 16);
+        ctx->bytepos = 16;
+        data += 16;
+        len -= 16;
+    }
 
-    return &ctx->mac;
+    while (len--)
+        eax128_omac_process(ctx, *data++);
 }
 
 void eax128_omac_clear(eax128_omac_t *ctx)
@@ -131,50 +218,107 @@ void eax128_omac_clear(eax128_omac_t *ctx)
 }
 
 
-void eax128_ctr_init(eax128_ctr_t *ctx, void *cipher_ctx, const uint8_t nonce[16])
+void eax128_ctr_init(eax128_ctr_t *ctx, const eax128_key_t *key, const uint8_t nonce[16])
 {
     memset(ctx, 0, sizeof(eax128_ctr_t));
     memcpy(ctx->nonce.b, nonce, 16);
     ctx->blocknum = -1;    // something nonzero
-    ctx->cipher_ctx = cipher_ctx;
+    ctx->key = key;
 }
 
-int eax128_ctr_process(eax128_ctr_t *ctx, unsigned int pos, int byte)
+static void ctr_load_block(eax128_ctr_t *ctx, uint64_t blocknum)
 {
-    unsigned int blocknum = pos / 16;
     if (blocknum != ctx->blocknum)    // change of block
     {
         ctx->blocknum = blocknum;
         add_ctr(&ctx->xorbuf, &ctx->nonce, blocknum);
-        eax128_cipher(ctx->cipher_ctx, ctx->xorbuf.b);
+        eax128_cipher(ctx->key->cipher_ctx, ctx->xorbuf.b);
     }
+}
+
+int eax128_ctr_process(eax128_ctr_t *ctx, uint64_t pos, int byte)
+{
+    ctr_load_block(ctx, pos / 16);
 
     return ctx->xorbuf.b[pos % 16] ^ byte;
 
 }
 
+void eax128_ctr_process_buf(eax128_ctr_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    // unaligned head
+    while (len && (pos % 16) != 0)
+    {
+        *out++ = eax128_ctr_process(ctx, pos++, *in++);
+        len--;
+    }
+
+    while (len >= 16)
+    {
+        eax128_block_t ks[CTR_BATCH];
+        uint64_t blocknum = pos / 16;
+        unsigned int n = len / 16 < CTR_BATCH ? len / 16 : CTR_BATCH;
+
+        for (unsigned int i = 0; i < n; i++)
+            add_ctr(&ks[i], &ctx->nonce, blocknum + i);
+        cipher_blocks(ctx->key->cipher_ctx, ks, n);
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            eax128_block_t data;
+
+            memcpy(data.b, in, 16);     // in and out may be unaligned or the same
+            xor128(&data, &data, &ks[i]);
+            memcpy(out, data.b, 16);
+
+            in += 16;
+            out += 16;
+        }
+
+        // keep the last block for the following byte calls
+        ctx->xorbuf = ks[n - 1];
+        ctx->blocknum = blocknum + n - 1;
+
+        pos += n * 16;
+        len -= n * 16;
+    }
+
+    while (len--)
+        *out++ = eax128_ctr_process(ctx, pos++, *in++);
+}
+
 void eax128_ctr_clear(eax128_ctr_t *ctx)
 {
     memset(ctx, 0, sizeof(eax128_ctr_t));
 }
 
 
-void eax128_init(eax128_t *ctx, void *cipher_ctx, const uint8_t *nonce, unsigned int nonce_len)
+void eax128_init(eax128_t *ctx, const eax128_key_t *key, const uint8_t *nonce, unsigned int nonce_len)
 {
+    ctx->ctr.key = key;
+    eax128_reset(ctx, nonce, nonce_len);
+}
+
+void eax128_reset(eax128_t *ctx, const uint8_t *nonce, unsigned int nonce_len)
+{
+    // the ctr keeps the key pointer between messages (the digest clears the omacs only)
+    const eax128_key_t *key = ctx->ctr.key;
+
     // the parts of ctx are cleared by called functions
 
     // reuse header omac to avoid stack
     eax128_omac_t *nomac = &ctx->homac;
 
-    eax128_omac_init(nomac, cipher_ctx, 0);
-    for (unsigned int i = 0; i < nonce_len; i++)
-        eax128_omac_process(nomac, nonce[i]);
+    eax128_omac_init(nomac, key, 0);
+    eax128_omac_process_buf(nomac, nonce, nonce_len);
     eax128_omac_digest(nomac);
-    eax128_ctr_init(&ctx->ctr, cipher_ctx, nomac->mac.b);
+    eax128_ctr_init(&ctx->ctr, key, nomac->mac.b);
 
     // this init will clear nonceomac too
-    eax128_omac_init(&ctx->homac, cipher_ctx, 1);
-    eax128_omac_init(&ctx->domac, cipher_ctx, 2);
+    eax128_omac_init(&ctx->homac, key, 1);
+    eax128_omac_init(&ctx->domac, key, 2);
+
+    ctx->encpos = 0;
 }
 
 
@@ -188,11 +332,102 @@ void eax128_auth_header(eax128_t *ctx, int byte)
     eax128_omac_process(&ctx->homac, byte);
 }
 
-int eax128_crypt_data(eax128_t *ctx, unsigned int pos, int byte)
+int eax128_crypt_data(eax128_t *ctx, uint64_t pos, int byte)
 {
     return eax128_ctr_process(&ctx->ctr, pos, byte);
 }
 
+void eax128_auth_data_buf(eax128_t *ctx, const uint8_t *data, size_t len)
+{
+    eax128_omac_process_buf(&ctx->domac, data, len);
+}
+
+void eax128_auth_header_buf(eax128_t *ctx, const uint8_t *data, size_t len)
+{
+    eax128_omac_process_buf(&ctx->homac, data, len);
+}
+
+void eax128_crypt_buf(eax128_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    eax128_ctr_process_buf(&ctx->ctr, pos, in, out, len);
+}
+
+void eax128_encrypt_update(eax128_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    eax128_omac_t *omac = &ctx->domac;
+    eax128_ctr_t *ctr = &ctx->ctr;
+    uint64_t pos = ctx->encpos;
+
+    ctx->encpos += len;
+
+    // bytewise until both the ctr and omac are at the block boundary.
+    // if data omac was fed separately they never meet and it's all bytewise, but still correct
+    while (len && ((pos % 16) != 0 || (omac->bytepos % 16) != 0))
+    {
+        int c = eax128_ctr_process(ctr, pos++, *in++);
+        eax128_omac_process(omac, c);
+        *out++ = c;
+        len--;
+    }
+
+    // the fused loop. the keystream for the group of blocks goes to the cipher in a single batch with
+    // the pending omac block. the rest of the group omac is serial.
+    // the ciphertext is produced right into the pending omac block.
+    // it takes the batch of 2 at least, otherwise it's all the bytewise tail below
+    while (CTR_BATCH >= 2 && len >= 16)
+    {
+        eax128_block_t batch[CTR_BATCH];
+        eax128_block_t *ks = &batch[1];
+        uint64_t blocknum = pos / 16;
+        unsigned int n = len / 16 < CTR_BATCH - 1 ? len / 16 : CTR_BATCH - 1;
+        int absorb = omac->bytepos == 16;
+
+        xor128(&batch[0], &omac->mac, &omac->block);
+        for (unsigned int i = 0; i < n; i++)
+            add_ctr(&ks[i], &ctr->nonce, blocknum + i);
+
+        if (absorb)
+        {
+            cipher_blocks(omac->key->cipher_ctx, batch, n + 1);
+            omac->mac = batch[0];
+        }
+        else
+        {
+            cipher_blocks(omac->key->cipher_ctx, ks, n);
+        }
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            if (i != 0)
+            {
+                xor128(&omac->mac, &omac->mac, &omac->block);
+                eax128_cipher(omac->key->cipher_ctx, omac->mac.b);
+            }
+
+            memcpy(omac->block.b, in, 16);
+            xor128(&omac->block, &omac->block, &ks[i]);
+            memcpy(out, omac->block.b, 16);
+
+            in += 16;
+            out += 16;
+        }
+        omac->bytepos = 16;
+
+        ctr->xorbuf = ks[n - 1];
+        ctr->blocknum = blocknum + n - 1;
+
+        pos += n * 16;
+        len -= n * 16;
+    }
+
+    while (len--)
+    {
+        int c = eax128_ctr_process(ctr, pos++, *in++);
+        eax128_omac_process(omac, c);
+        *out++ = c;
+    }
+}
+
 void eax128_digest(eax128_t *ctx, uint8_t tag[16])
 {
     eax128_block_t *t = (eax128_block_t *)(void *)tag;
@@ -207,6 +442,445 @@ void eax128_digest(eax128_t *ctx, uint8_t tag[16])
     eax128_omac_clear(&ctx->homac);
 }
 
+// the omac over the complete buffer. used for the interleaved processing of the independent chains
+typedef struct
+{
+    eax128_block_t mac;
+    const uint8_t *data;
+    size_t len;             // bytes left
+} omac_chain_t;
+
+static void chain_init(omac_chain_t *c, const eax128_key_t *key, int k, const uint8_t *data, size_t len)
+{
+    c->mac = len ? key->tweak[k] : key->empty[k];
+    c->data = data;
+    c->len = len;
+}
+
+// prepare the next cipher input of the chain. returns 0 if the chain is done
+static int chain_load(omac_chain_t *c, const eax128_key_t *key, eax128_block_t *dst)
+{
+    eax128_block_t block;
+
+    if (c->len == 0)
+        return 0;
+
+    if (c->len > 16)
+    {
+        memcpy(block.b, c->data, 16);
+        xor128(dst, &c->mac, &block);
+        c->data += 16;
+        c->len -= 16;
+        return 1;
+    }
+
+    // the last block
+    block.q[0] = 0;
+    block.q[1] = 0;
+    memcpy(block.b, c->data, c->len);
+    if (c->len != 16)
+        block.b[c->len] = 0x80;
+
+    xor128(dst, &c->mac, &block);
+    xor128(dst, dst, c->len == 16 ? &key->l2 : &key->l4);
+    c->len = 0;
+    return 1;
+}
+
+int eax128_decrypt_verify(const eax128_key_t *key,
+                          const uint8_t *nonce, unsigned int nonce_len,
+                          const uint8_t *header, size_t header_len,
+                          const uint8_t *ct, size_t len,
+                          const uint8_t *tag, unsigned int tag_len,
+                          uint8_t *pt)
+{
+    omac_chain_t chains[3];
+    eax128_block_t batch[3 + CTR_BATCH];
+    omac_chain_t *owner[3];
+
+    // with the separate pt the ctr runs in the same batches, the pt is zeroed on failure.
+    // in place the ct must stay intact for the omac, so the ctr runs after the compare
+    int fused = pt != ct;
+    uint64_t ctr_pos = 0;
+    uint64_t ctr_end = (len + 15) / 16;
+
+    chain_init(&chains[0], key, 0, nonce, nonce_len);
+    chain_init(&chains[1], key, 1, header, header_len);
+    chain_init(&chains[2], key, 2, ct, len);
+
+    // the nonce, header and data chains are independent, so each step issues a block of each to the cipher at once
+    while (1)
+    {
+        unsigned int n = 0;
+        unsigned int m = 0;
+        int nonce_done = chains[0].len == 0;    // the ctr needs the final nonce mac
+
+        for (int i = 0; i < 3; i++)
+        {
+            if (chain_load(&chains[i], key, &batch[n]))
+                owner[n++] = &chains[i];
+        }
+
+        // the data omac is serial, it sets the number of steps. the keystream blocks are spread evenly over them
+        if (fused && nonce_done && ctr_pos < ctr_end)
+        {
+            uint64_t steps = (n && owner[n - 1] == &chains[2]) + (chains[2].len + 15) / 16;
+            uint64_t left = ctr_end - ctr_pos;
+
+            m = steps ? (left + steps - 1) / steps : left;
+            if (m > CTR_BATCH)
+                m = CTR_BATCH;
+
+            for (unsigned int i = 0; i < m; i++)
+                add_ctr(&batch[n + i], &chains[0].mac, ctr_pos + i);
+        }
+
+        if (n + m == 0)
+            break;
+
+        cipher_blocks(key->cipher_ctx, batch, n + m);
+
+        for (unsigned int i = 0; i < n; i++)
+            owner[i]->mac = batch[i];
+
+        for (unsigned int i = 0; i < m; i++)
+        {
+            eax128_block_t data = {{0}};
+            size_t off = (ctr_pos + i) * 16;
+            size_t k = len - off < 16 ? len - off : 16;
+
+            memcpy(data.b, ct + off, k);
+            xor128(&data, &data, &batch[n + i]);
+            memcpy(pt + off, data.b, k);
+        }
+        ctr_pos += m;
+    }
+
+    eax128_block_t local_tag;
+    xor128(&local_tag, &chains[0].mac, &chains[1].mac);
+    xor128(&local_tag, &local_tag, &chains[2].mac);
+
+    // constant-time compare. the empty tag proves nothing
+    uint8_t diff = tag_len == 0 || tag_len > 16;
+    for (unsigned int i = 0; i < tag_len && i < 16; i++)
+        diff |= local_tag.b[i] ^ tag[i];
+
+    // the plaintext is released only if authentic
+    if (diff != 0 && fused && len)
+    {
+        memset(pt, 0, len);
+    }
+    else if (diff == 0 && !fused)
+    {
+        eax128_ctr_t ctr;
+
+        eax128_ctr_init(&ctr, key, chains[0].mac.b);
+        eax128_ctr_process_buf(&ctr, 0, ct, pt, len);
+        eax128_ctr_clear(&ctr);
+    }
+
+    memset(chains, 0, sizeof(chains));
+    memset(batch, 0, sizeof(batch));
+    memset(&local_tag, 0, sizeof(local_tag));
+
+    return diff == 0 ? 0 : -1;
+}
+
+void eax128_verify_batch(const eax128_key_t *key, const eax128_msg_t *msgs, unsigned int n, uint8_t *ok)
+{
+    struct
+    {
+        const eax128_msg_t *msg;
+        unsigned int idx;
+        omac_chain_t chains[3];
+    } lanes[BATCH_LANES];
+
+    eax128_block_t batch[3 * BATCH_LANES];
+    omac_chain_t *owner[3 * BATCH_LANES];
+    unsigned int next = 0;
+    unsigned int active = 0;
+
+    memset(ok, 0, (n + 7) / 8);
+
+    for (int l = 0; l < BATCH_LANES; l++)
+        lanes[l].msg = NULL;
+
+    // each lane runs the three chains of its message. a cipher call gets a block of each chain of each lane.
+    // the finished lane takes the next message, so the lanes are kept busy
+    while (1)
+    {
+        unsigned int nb = 0;
+
+        for (int l = 0; l < BATCH_LANES; l++)
+        {
+            if (!lanes[l].msg && next < n)
+            {
+                const eax128_msg_t *m = &msgs[next];
+                lanes[l].msg = m;
+                lanes[l].idx = next++;
+                chain_init(&lanes[l].chains[0], key, 0, m->nonce, m->nonce_len);
+                chain_init(&lanes[l].chains[1], key, 1, m->header, m->header_len);
+                chain_init(&lanes[l].chains[2], key, 2, m->ct, m->len);
+                active++;
+            }
+
+            if (!lanes[l].msg)
+                continue;
+
+            for (int i = 0; i < 3; i++)
+            {
+                if (chain_load(&lanes[l].chains[i], key, &batch[nb]))
+                    owner[nb++] = &lanes[l].chains[i];
+            }
+        }
+
+        if (nb)
+            cipher_blocks(key->cipher_ctx, batch, nb);
+
+        for (unsigned int i = 0; i < nb; i++)
+            owner[i]->mac = batch[i];
+
+        for (int l = 0; l < BATCH_LANES; l++)
+        {
+            omac_chain_t *c = lanes[l].chains;
+            const eax128_msg_t *m = lanes[l].msg;
+
+            if (!m || c[0].len || c[1].len || c[2].len)
+                continue;
+
+            eax128_block_t local_tag;
+            xor128(&local_tag, &c[0].mac, &c[1].mac);
+            xor128(&local_tag, &local_tag, &c[2].mac);
+
+            uint8_t diff = m->tag_len == 0 || m->tag_len > 16;
+            for (unsigned int i = 0; i < m->tag_len && i < 16; i++)
+                diff |= local_tag.b[i] ^ m->tag[i];
+
+            ok[lanes[l].idx / 8] |= (diff == 0) << (lanes[l].idx % 8);
+
+            lanes[l].msg = NULL;
+            active--;
+        }
+
+        if (!active && next >= n)
+            break;
+    }
+
+    memset(lanes, 0, sizeof(lanes));
+    memset(batch, 0, sizeof(batch));
+}
+
+
+// the compact context. the omac state is the mac xored with the pending block bytes, so a single block does.
+// the pending block is absorbed by the encryption of the accumulator once more data arrives,
+// or finalized by the L * 2 / L * 4 xor on digest
+static void cmac_update(const eax128_key_t *key, eax128_block_t *acc, uint64_t *dlen, const uint8_t *data, size_t len)
+{
+    while (len)
+    {
+        unsigned int r = *dlen % 16;
+
+        if (r == 0 && *dlen != 0)
+            eax128_cipher(key->cipher_ctx, acc->b);
+
+        if (r == 0 && len >= 16)
+        {
+            eax128_block_t block;
+
+            memcpy(block.b, data, 16);
+            xor128(acc, acc, &block);
+            *dlen += 16;
+            data += 16;
+            len -= 16;
+        }
+        else
+        {
+            acc->b[r] ^= *data++;
+            *dlen += 1;
+            len--;
+        }
+    }
+}
+
+void eax128c_init(eax128c_t *ctx, const eax128_key_t *key,
+                  const uint8_t *nonce, unsigned int nonce_len,
+                  const uint8_t *header, size_t header_len)
+{
+    ctx->key = key;
+    eax128c_reset(ctx, nonce, nonce_len, header, header_len);
+}
+
+void eax128c_reset(eax128c_t *ctx, const uint8_t *nonce, unsigned int nonce_len, const uint8_t *header, size_t header_len)
+{
+    const eax128_key_t *key = ctx->key;
+    omac_chain_t chains[2];
+    eax128_block_t batch[2];
+    omac_chain_t *owner[2];
+
+    // the nonce and header omacs are independent, so they go to the cipher in pairs
+    chain_init(&chains[0], key, 0, nonce, nonce_len);
+    chain_init(&chains[1], key, 1, header, header_len);
+
+    while (1)
+    {
+        unsigned int n = 0;
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (chain_load(&chains[i], key, &batch[n]))
+                owner[n++] = &chains[i];
+        }
+
+        if (n == 0)
+            break;
+
+        cipher_blocks(key->cipher_ctx, batch, n);
+
+        for (unsigned int i = 0; i < n; i++)
+            owner[i]->mac = batch[i];
+    }
+
+    ctx->nonce = chains[0].mac;
+    xor128(&ctx->nh, &chains[0].mac, &chains[1].mac);
+    ctx->dacc = key->tweak[2];
+    ctx->dlen = 0;
+
+    memset(chains, 0, sizeof(chains));
+    memset(batch, 0, sizeof(batch));
+}
+
+void eax128c_auth_data_buf(eax128c_t *ctx, const uint8_t *data, size_t len)
+{
+    cmac_update(ctx->key, &ctx->dacc, &ctx->dlen, data, len);
+}
+
+// there is no keystream cache, the blocks covering the range are encrypted on every call
+void eax128c_crypt_buf(eax128c_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    while (len)
+    {
+        eax128_block_t ks[CTR_BATCH];
+        uint64_t blocknum = pos / 16;
+        unsigned int off = pos % 16;
+        size_t nblocks = (off + len + 15) / 16;
+        unsigned int n = nblocks < CTR_BATCH ? nblocks : CTR_BATCH;
+
+        for (unsigned int i = 0; i < n; i++)
+            add_ctr(&ks[i], &ctx->nonce, blocknum + i);
+        cipher_blocks(ctx->key->cipher_ctx, ks, n);
+
+        size_t m = n * 16 - off < len ? n * 16 - off : len;
+        const uint8_t *k = &ks[0].b[off];
+
+        for (size_t i = 0; i < m; i++)
+            out[i] = in[i] ^ k[i];
+
+        in += m;
+        out += m;
+        pos += m;
+        len -= m;
+    }
+}
+
+void eax128c_encrypt_update(eax128c_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    const eax128_key_t *key = ctx->key;
+    eax128_block_t *acc = &ctx->dacc;
+
+    // unaligned head
+    if (ctx->dlen % 16)
+    {
+        size_t m = 16 - ctx->dlen % 16 < len ? 16 - ctx->dlen % 16 : len;
+
+        eax128c_crypt_buf(ctx, ctx->dlen, in, out, m);
+        cmac_update(key, acc, &ctx->dlen, out, m);
+        in += m;
+        out += m;
+        len -= m;
+    }
+
+    // the fused loop of eax128_encrypt_update: the pending block is absorbed in the keystream batch.
+    // with the batch of 1 the whole data goes to the tail below
+    while (CTR_BATCH >= 2 && len >= 16)
+    {
+        eax128_block_t batch[CTR_BATCH];
+        eax128_block_t *ks = &batch[1];
+        uint64_t blocknum = ctx->dlen / 16;
+        unsigned int n = len / 16 < CTR_BATCH - 1 ? len / 16 : CTR_BATCH - 1;
+        int absorb = ctx->dlen != 0;
+
+        batch[0] = *acc;
+        for (unsigned int i = 0; i < n; i++)
+            add_ctr(&ks[i], &ctx->nonce, blocknum + i);
+
+        if (absorb)
+        {
+            cipher_blocks(key->cipher_ctx, batch, n + 1);
+            *acc = batch[0];
+        }
+        else
+        {
+            cipher_blocks(key->cipher_ctx, ks, n);
+        }
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            eax128_block_t data;
+
+            if (i != 0)
+                eax128_cipher(key->cipher_ctx, acc->b);
+
+            memcpy(data.b, in, 16);
+            xor128(&data, &data, &ks[i]);
+            memcpy(out, data.b, 16);
+            xor128(acc, acc, &data);
+
+            in += 16;
+            out += 16;
+        }
+
+        ctx->dlen += n * 16;
+        len -= n * 16;
+    }
+
+    if (len)
+    {
+        eax128c_crypt_buf(ctx, ctx->dlen, in, out, len);
+        cmac_update(key, acc, &ctx->dlen, out, len);
+    }
+}
+
+// the context is left as is, so the digest may be taken midway and the stream continued
+void eax128c_digest(const eax128c_t *ctx, uint8_t tag[16])
+{
+    const eax128_key_t *key = ctx->key;
+    eax128_block_t d;
+
+    if (ctx->dlen == 0)
+    {
+        d = key->empty[2];
+    }
+    else
+    {
+        unsigned int r = ctx->dlen % 16;
+
+        d = ctx->dacc;
+        if (r != 0)
+            d.b[r] ^= 0x80;
+        xor128(&d, &d, r == 0 ? &key->l2 : &key->l4);
+        eax128_cipher(key->cipher_ctx, d.b);
+    }
+
+    xor128(&d, &d, &ctx->nh);
+    memcpy(tag, d.b, 16);
+    memset(&d, 0, sizeof(d));
+}
+
+void eax128c_clear(eax128c_t *ctx)
+{
+    memset(ctx, 0, sizeof(eax128c_t));
+}
+
 void eax128_clear(eax128_t *ctx)
 {
     memset(ctx, 0, sizeof(eax128_t));
@@ -1,11 +1,16 @@
 #ifndef _EAX128_H_
 #define _EAX128_H_
 
+#include <stddef.h>
+
 /*
     The EAX flow:
 
+ 0) Once per key, precompute the key-dependent values:
+      eax_key_init(key, cipher_ctx)
+
  1) Collect the nonce of the message, init
-      eax_init(nonce)
+      eax_init(key, nonce)
 
  2) Auth the header and data byte-by-byte in any order:
       for each header_byte:
@@ -20,22 +25,75 @@
       for each ciphertext_byte:
           plaintext_byte = eax_decrypt_ct(ciphertext_byte)
 
- 6) Clear EAX:
+ 6) Start the next message under the same key, or clear EAX:
+       eax_reset(nonce)
        eax_clear
 
 
  Notes:
 
- cipher_ctx argument is passed to the each eax_cipher call
+ The key-dependent values (the OMAC subkeys L*2, L*4 and the encrypted tweak blocks) are precomputed once per key by the eax_key_init
+ and kept in the key struct. The key struct should live while the contexts referencing it are in use.
+ cipher_ctx argument of eax_key_init is passed to the each eax_cipher call
+ The key struct is read-only after the eax_key_init, so any number of contexts in any number of threads may share it,
+ as long as the cipher itself is re-entrant for the same cipher_ctx (the backends here are).
+
+ eax_reset starts the next message of the context under the same key. It's the eax_init without the key argument,
+ i.e. only the nonce-dependent work is done. It's fine after the eax_digest or mid-message (the message is dropped),
+ but not after the eax_clear.
 
  eax_decrypt_ct may be called while auth in progress.
  Pos is the ciphertext byte position and random access is fine.
+ The positions and block counters are 64-bit, so a single stream may be of any practical size.
+ The buffer lengths are size_t.
 
  eax_digest finalizes the auths, i.e. the eax_auth_* shouldn't be called after that.
 
+ The *_buf functions are the bulk versions of the byte ones. They process the whole blocks at once
+ and are bit-compatible with the byte functions, i.e. the calls may be mixed freely.
+ eax_crypt_buf may work in place (in == out).
+
+ The encryption flow is the same, but with the plaintext pushed via the
+      eax_encrypt_update(plaintext, ciphertext)
+ It produces the ciphertext and auths it in a single pass. The ciphertext stream position is
+ tracked internally (starting from 0 at init), so the calls should be sequential.
+ Don't mix it with the eax_auth_data for the same message.
+
+
+ eax_decrypt_verify is the whole decrypt flow above in a single call. The tag is compared in
+ constant time and the plaintext is released only if it matches. Returns 0 if ok, -1 on auth failure.
+ The truncated tags are fine, but the empty one is always a failure.
+ The nonce, header and data OMACs are interleaved. The data OMAC is serial, so it takes a cipher call per
+ block whatever is done. With the separate pt buffer the CTR blocks are spread over these calls, so each
+ one gets the data OMAC block, about a keystream block (more for the short nonce-led messages) and
+ the header block while it lasts, and the pt is zeroed on failure.
+ The pt may be the same buffer as ct (but not the partially overlapping one), then the data OMAC goes
+ a block per call and the CTR runs batched after the compare.
+
+
+ eax_verify_batch checks the tags of many messages under the same key, without decryption.
+ The messages are processed in lockstep lanes (BATCH_LANES in eax128.c, 8 by default), so each cipher
+ call gets a block of each OMAC chain of each lane, i.e. up to 3 * BATCH_LANES independent blocks.
+ The result is the bitmap: bit (i % 8) of ok[i / 8] is set if message i is authentic.
+
+
+ eax128c_t is the compact context for the many concurrent streams, 64 bytes on the 64-bit hosts (a cache line if aligned),
+ against the 152 of the eax128_t. The savings are:
+   - the key pointer is stored once
+   - the header is authed at eax128c_init, so the header omac is folded into the N ^ H
+   - the data omac state is a single block, the mac xored with the bytes of the pending block
+   - there is no keystream block cache (xorbuf), eax128c_crypt_buf encrypts the blocks it needs on every call.
+     So it's the bulk API only: the short calls still cost a cipher block each
+   - the data length is the only counter, both the omac and the ctr positions are derived from it
+ The flow is eax128c_init(header) -> eax128c_encrypt_update or eax128c_auth_data_buf + eax128c_crypt_buf -> eax128c_digest.
+ The data is sequential, like for the eax_encrypt_update. eax128c_crypt_buf is random-access.
+ eax128c_digest doesn't change the context, so it may be taken midway.
+ eax128c_reset is the eax_reset.
+
 
  OMAC and CTR internal functions are made public since they could be useful on their own.
- The OMAC functions are not generic but with a tweak: a single block with last byte == k is 'prepended' before the data
+ The OMAC functions are not generic but with a tweak: a single block with last byte == k is 'prepended' before the data.
+ Only the tweaks 0, 1, 2 are supported since their encryptions are precomputed.
 
 
  See crypt64.c/h for 64-bit ciphers eax
@@ -54,24 +112,58 @@ typedef union
 typedef struct
 {
     void *cipher_ctx;
+    eax128_block_t l2;      // L * 2, L = E(0)
+    eax128_block_t l4;      // L * 4
+    eax128_block_t tweak[3];    // E([k]), the omac state after the tweak block
+    eax128_block_t empty[3];    // E([k] ^ L * 2), the omac of empty data
+} eax128_key_t;
+
+typedef struct
+{
+    const eax128_key_t *key;
     eax128_block_t mac;
-    eax128_block_t block;
-    unsigned int bytepos;
+    eax128_block_t block;   // the last block is kept until more data or digest
+    unsigned int bytepos;   // bytes in block, 0 - 16
+    int k;
 } eax128_omac_t;
 
 typedef struct
 {
-    void *cipher_ctx;
+    const eax128_key_t *key;
     eax128_block_t nonce;
     eax128_block_t xorbuf;
-    unsigned int blocknum;
+    uint64_t blocknum;
 } eax128_ctr_t;
 
+// message descriptor for the eax_verify_batch
+typedef struct
+{
+    const uint8_t *nonce;
+    unsigned int nonce_len;
+    const uint8_t *header;
+    size_t header_len;
+    const uint8_t *ct;
+    size_t len;
+    const uint8_t *tag;
+    unsigned int tag_len;
+} eax128_msg_t;
+
+// compact context, see the notes
+typedef struct
+{
+    const eax128_key_t *key;
+    eax128_block_t nonce;   // N, the ctr base
+    eax128_block_t nh;      // N ^ H
+    eax128_block_t dacc;    // data omac mac ^ pending block
+    uint64_t dlen;          // data bytes authed
+} eax128c_t;
+
 typedef struct
 {
     eax128_omac_t domac;
     eax128_omac_t homac;
     eax128_ctr_t ctr;
+    uint64_t encpos;        // stream position of the eax_encrypt_update
 } eax128_t;
 
 
@@ -80,23 +172,57 @@ typedef struct
 // The cipher must process the data in place
 extern void eax128_cipher(void *ctx, uint8_t pt[16]);
 
+// The optional multi-block cipher, the n blocks of 16 bytes are processed in place.
+// The blocks are independent, so the pipelined or SIMD cipher may process them in parallel.
+// It's used if eax128.c is built with USE_CIPHER_BLOCKS=1, otherwise the blocks are passed to eax128_cipher one by one
+extern void eax128_cipher_blocks(void *ctx, uint8_t *blocks, unsigned int n);
+
+
+void eax128_key_init(eax128_key_t *key, void *cipher_ctx);
+void eax128_key_clear(eax128_key_t *key);
 
-void eax128_init(eax128_t *ctx, void *cipher_ctx, const uint8_t *nonce, unsigned int nonce_len);
+void eax128_init(eax128_t *ctx, const eax128_key_t *key, const uint8_t *nonce, unsigned int nonce_len);
+void eax128_reset(eax128_t *ctx, const uint8_t *nonce, unsigned int nonce_len);
 void eax128_auth_data(eax128_t *ctx, int byte);
 void eax128_auth_header(eax128_t *ctx, int byte);
-int eax128_crypt_data(eax128_t *ctx, unsigned int pos, int byte);
-void eax128_digest(eax128_t *ctx, uint8_t tag[8]);
+int eax128_crypt_data(eax128_t *ctx, uint64_t pos, int byte);
+void eax128_auth_data_buf(eax128_t *ctx, const uint8_t *data, size_t len);
+void eax128_auth_header_buf(eax128_t *ctx, const uint8_t *data, size_t len);
+void eax128_crypt_buf(eax128_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
+void eax128_encrypt_update(eax128_t *ctx, const uint8_t *in, uint8_t *out, size_t len);
+void eax128_digest(eax128_t *ctx, uint8_t tag[16]);
 void eax128_clear(eax128_t *ctx);
 
+int eax128_decrypt_verify(const eax128_key_t *key,
+                          const uint8_t *nonce, unsigned int nonce_len,
+                          const uint8_t *header, size_t header_len,
+                          const uint8_t *ct, size_t len,
+                          const uint8_t *tag, unsigned int tag_len,
+                          uint8_t *pt);
+
+void eax128_verify_batch(const eax128_key_t *key, const eax128_msg_t *msgs, unsigned int n, uint8_t *ok);
+
+void eax128c_init(eax128c_t *ctx, const eax128_key_t *key,
+                  const uint8_t *nonce, unsigned int nonce_len,
+                  const uint8_t *header, size_t header_len);
+void eax128c_reset(eax128c_t *ctx, const uint8_t *nonce, unsigned int nonce_len, const uint8_t *header, size_t header_len);
+void eax128c_auth_data_buf(eax128c_t *ctx, const uint8_t *data, size_t len);
+void eax128c_crypt_buf(eax128c_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
+void eax128c_encrypt_update(eax128c_t *ctx, const uint8_t *in, uint8_t *out, size_t len);
+void eax128c_digest(const eax128c_t *ctx, uint8_t tag[16]);
+void eax128c_clear(eax128c_t *ctx);
+
 
 
-void eax128_omac_init(eax128_omac_t *ctx, void *cipher_ctx, int k);
+void eax128_omac_init(eax128_omac_t *ctx, const eax128_key_t *key, int k);
 void eax128_omac_process(eax128_omac_t *ctx, int byte);
+void eax128_omac_process_buf(eax128_omac_t *ctx, const uint8_t *data, size_t len);
 eax128_block_t *eax128_omac_digest(eax128_omac_t *ctx);
 void eax128_omac_clear(eax128_omac_t *ctx);
 
-void eax128_ctr_init(eax128_ctr_t *ctx, void *cipher_ctx, const uint8_t nonce[16]);
-int eax128_ctr_process(eax128_ctr_t *ctx, unsigned int pos, int byte);
+void eax128_ctr_init(eax128_ctr_t *ctx, const eax128_key_t *key, const uint8_t nonce[16]);
+int eax128_ctr_process(eax128_ctr_t *ctx, uint64_t pos, int byte);
+void eax128_ctr_process_buf(eax128_ctr_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
 void eax128_ctr_clear(eax128_ctr_t *ctx);
 
 
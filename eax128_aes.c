@@ -0,0 +1,212 @@
+#include <stdint.h>
+#include <string.h>
+#include "eax128.h"
+#include "eax128_aes.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include "aes128vaes.h"
+#else
+#define HAVE_X86 0
+#endif
+
+typedef struct
+{
+    eax128_aes_backend_t id;
+    const char *name;
+    int (*supported)(void);
+    void (*set_key)(eax128_aes_ctx_t *ctx, const uint8_t key[16]);
+    void (*encrypt)(const eax128_aes_ctx_t *ctx, uint8_t block[16]);
+    void (*encrypt_blocks)(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n);
+} backend_t;
+
+
+static int always(void)
+{
+    return 1;
+}
+
+// portable
+static void portable_set_key(eax128_aes_ctx_t *ctx, const uint8_t key[16])
+{
+    aes128_ctx_set_key(&ctx->u.portable, key);
+}
+
+static void portable_encrypt(const eax128_aes_ctx_t *ctx, uint8_t block[16])
+{
+    aes128_ctx_encrypt(&ctx->u.portable, block);
+}
+
+static void portable_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    for (unsigned int i = 0; i < n; i++)
+        aes128_ctx_encrypt(&ctx->u.portable, &blocks[i * 16]);
+}
+
+// T-table
+static void tt_set_key(eax128_aes_ctx_t *ctx, const uint8_t key[16])
+{
+    aes128tt_set_key(&ctx->u.tt, key);
+}
+
+static void tt_encrypt(const eax128_aes_ctx_t *ctx, uint8_t block[16])
+{
+    aes128tt_encrypt(&ctx->u.tt, block);
+}
+
+static void tt_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    aes128tt_encrypt_blocks(&ctx->u.tt, blocks, n);
+}
+
+// bitsliced
+static void bs_set_key(eax128_aes_ctx_t *ctx, const uint8_t key[16])
+{
+    aes128bs_set_key(&ctx->u.bs, key);
+}
+
+static void bs_encrypt(const eax128_aes_ctx_t *ctx, uint8_t block[16])
+{
+    aes128bs_encrypt(&ctx->u.bs, block);
+}
+
+static void bs_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    aes128bs_encrypt_blocks(&ctx->u.bs, blocks, n);
+}
+
+#if HAVE_X86
+// AES-NI and VAES, the same key schedule
+static void ni_set_key(eax128_aes_ctx_t *ctx, const uint8_t key[16])
+{
+    aes128ni_set_key(&ctx->u.ni, key);
+}
+
+static void ni_encrypt(const eax128_aes_ctx_t *ctx, uint8_t block[16])
+{
+    aes128ni_encrypt(&ctx->u.ni, block);
+}
+
+static void ni_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    aes128ni_encrypt_blocks(&ctx->u.ni, blocks, n);
+}
+
+static void vaes_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    aes128vaes_encrypt_blocks(&ctx->u.ni, blocks, n);
+}
+#endif
+
+// indexed by eax128_aes_backend_t. NULL if not compiled in
+static const backend_t *const backends[EAX128_AES_NBACKENDS] =
+{
+    [EAX128_AES_PORTABLE] = &(const backend_t){EAX128_AES_PORTABLE, "portable", always, portable_set_key, portable_encrypt, portable_encrypt_blocks},
+    [EAX128_AES_TTABLE] = &(const backend_t){EAX128_AES_TTABLE, "ttable", always, tt_set_key, tt_encrypt, tt_encrypt_blocks},
+    [EAX128_AES_BITSLICED] = &(const backend_t){EAX128_AES_BITSLICED, "bitsliced", always, bs_set_key, bs_encrypt, bs_encrypt_blocks},
+#if HAVE_X86
+    [EAX128_AES_AESNI] = &(const backend_t){EAX128_AES_AESNI, "aesni", aes128ni_supported, ni_set_key, ni_encrypt, ni_encrypt_blocks},
+    [EAX128_AES_VAES] = &(const backend_t){EAX128_AES_VAES, "vaes", aes128vaes_supported, ni_set_key, ni_encrypt, vaes_encrypt_blocks},
+#endif
+};
+
+
+// published with release, the readers acquire it, so the probe is race-free
+static const backend_t *active;
+
+void eax128_aes_init(void)
+{
+    static const eax128_aes_backend_t order[] =
+    {
+        EAX128_AES_VAES,
+        EAX128_AES_AESNI,
+        EAX128_AES_ALLOW_TTABLE ? EAX128_AES_TTABLE : EAX128_AES_BITSLICED,
+    };
+    const backend_t *best = NULL;
+
+    if (__atomic_load_n(&active, __ATOMIC_ACQUIRE))
+        return;
+
+    for (int i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+    {
+        if (eax128_aes_supported(order[i]))
+        {
+            best = backends[order[i]];
+            break;
+        }
+    }
+
+    // the concurrent first calls probe the same backend. the first one publishes, a forced backend is kept
+    const backend_t *none = NULL;
+    __atomic_compare_exchange_n(&active, &none, best, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+static const backend_t *active_backend(void)
+{
+    eax128_aes_init();
+    return __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+}
+
+int eax128_aes_supported(eax128_aes_backend_t backend)
+{
+    if (backend < 0 || backend >= EAX128_AES_NBACKENDS || !backends[backend])
+        return 0;
+
+    return backends[backend]->supported();
+}
+
+int eax128_aes_force(eax128_aes_backend_t backend)
+{
+    if (!eax128_aes_supported(backend))
+        return -1;
+
+    eax128_aes_init();
+    __atomic_store_n(&active, backends[backend], __ATOMIC_RELEASE);
+    return 0;
+}
+
+eax128_aes_backend_t eax128_aes_backend(void)
+{
+    return active_backend()->id;
+}
+
+const char *eax128_aes_backend_name(void)
+{
+    return active_backend()->name;
+}
+
+
+void eax128_aes_set_key(eax128_aes_ctx_t *ctx, const uint8_t key[16])
+{
+    const backend_t *b = active_backend();
+
+    ctx->ops = b;
+    b->set_key(ctx, key);
+}
+
+void eax128_aes_encrypt(const eax128_aes_ctx_t *ctx, uint8_t block[16])
+{
+    ((const backend_t *)ctx->ops)->encrypt(ctx, block);
+}
+
+void eax128_aes_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    ((const backend_t *)ctx->ops)->encrypt_blocks(ctx, blocks, n);
+}
+
+void eax128_aes_clear(eax128_aes_ctx_t *ctx)
+{
+    memset(ctx, 0, sizeof(eax128_aes_ctx_t));
+}
+
+
+// eax128 hooks. ctx is the eax128_aes_ctx_t
+void eax128_cipher(void *ctx, uint8_t block[16])
+{
+    eax128_aes_encrypt(ctx, block);
+}
+
+void eax128_cipher_blocks(void *ctx, uint8_t *blocks, unsigned int n)
+{
+    eax128_aes_encrypt_blocks(ctx, blocks, n);
+}
@@ -0,0 +1,75 @@
+#ifndef _EAX128_AES_H_
+#define _EAX128_AES_H_
+
+#include "aes128.h"
+#include "aes128tt.h"
+#include "aes128bs.h"
+#include "aes128ni.h"
+
+/*
+    EAX-AES binding with the runtime CPU dispatch.
+
+    It implements the eax128_cipher and eax128_cipher_blocks hooks
+    for all the AES backends, so the one binary runs on the best one the CPU has.
+
+    The flow is:
+     1) eax128_aes_init() once. It probes the CPU and binds the best backend:
+        VAES > AES-NI > bitsliced (or T-table if built with EAX128_AES_ALLOW_TTABLE=1).
+        eax128_aes_force(backend) may override the choice (tests, benchmarks, known fleet)
+     2) eax128_aes_set_key(&aes, key), then eax128_key_init(&key, &aes)
+     3) use the eax128 as usual
+     4) eax128_aes_clear(&aes)
+
+    The context remembers the backend it was keyed with, so the contexts keyed before
+    the eax128_aes_force keep working.
+
+    eax128_aes_backend() and eax128_aes_backend_name() report the active backend. Log them.
+
+    The portable aes128_ctx backend is never chosen automatically, it's there for the reference.
+    The T-table one is fast, but not cache-timing safe, hence the opt-in.
+
+    eax128.c must be built with USE_CIPHER_BLOCKS=1 to get the bulk paths,
+    and with CTR_BATCH=16 BATCH_LANES=16 to give the VAES backend the full 16-block batches.
+    On non-x86 the AES-NI and VAES backends are compiled out.
+*/
+
+#ifndef EAX128_AES_ALLOW_TTABLE
+#define EAX128_AES_ALLOW_TTABLE 0
+#endif
+
+typedef enum
+{
+    EAX128_AES_PORTABLE,
+    EAX128_AES_TTABLE,
+    EAX128_AES_BITSLICED,
+    EAX128_AES_AESNI,
+    EAX128_AES_VAES,
+    EAX128_AES_NBACKENDS,
+} eax128_aes_backend_t;
+
+typedef struct
+{
+    const void *ops;    // backend the context is keyed for
+
+    union
+    {
+        aes128_ctx_t portable;
+        aes128tt_ctx_t tt;
+        aes128bs_ctx_t bs;
+        aes128ni_ctx_t ni;      // VAES uses it too
+    } u;
+} eax128_aes_ctx_t;
+
+void eax128_aes_init(void);
+int eax128_aes_supported(eax128_aes_backend_t backend);
+int eax128_aes_force(eax128_aes_backend_t backend);
+
+eax128_aes_backend_t eax128_aes_backend(void);
+const char *eax128_aes_backend_name(void);
+
+void eax128_aes_set_key(eax128_aes_ctx_t *ctx, const uint8_t key[16]);
+void eax128_aes_encrypt(const eax128_aes_ctx_t *ctx, uint8_t block[16]);
+void eax128_aes_encrypt_blocks(const eax128_aes_ctx_t *ctx, uint8_t *blocks, unsigned int n);
+void eax128_aes_clear(eax128_aes_ctx_t *ctx);
+
+#endif
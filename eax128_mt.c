@@ -0,0 +1,174 @@
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "eax128_mt.h"
+
+typedef struct
+{
+    const eax128_key_t *key;
+    const uint8_t *nonce;
+    uint64_t pos;
+    const uint8_t *in;
+    uint8_t *out;
+    size_t len;
+} chunk_t;
+
+typedef struct
+{
+    chunk_t chunks[EAX128_MT_MAX_THREADS];
+    pthread_t threads[EAX128_MT_MAX_THREADS];
+    int started[EAX128_MT_MAX_THREADS];
+    unsigned int n;
+} ctr_pool_t;
+
+static void *ctr_worker(void *arg)
+{
+    const chunk_t *c = arg;
+    eax128_ctr_t ctr;
+
+    eax128_ctr_init(&ctr, c->key, c->nonce);
+    eax128_ctr_process_buf(&ctr, c->pos, c->in, c->out, c->len);
+    eax128_ctr_clear(&ctr);
+
+    return NULL;
+}
+
+// split the range into n chunks. the boundaries are block-aligned in the stream, so no block is computed twice.
+// the first chunk takes the unaligned head
+static void ctr_split(ctr_pool_t *pool, const eax128_key_t *const keys[], unsigned int n, const uint8_t nonce[16],
+                      uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    uint64_t blocks = (pos % 16 + len + 15) / 16;
+    uint64_t start = pos;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        uint64_t end = (pos / 16 + blocks * (i + 1) / n) * 16;
+
+        if (i == n - 1 || end > pos + len)
+            end = pos + len;
+
+        pool->chunks[i] = (chunk_t){keys[i], nonce, start, in + (start - pos), out + (start - pos), end - start};
+        start = end;
+    }
+
+    pool->n = n;
+}
+
+static void ctr_start(ctr_pool_t *pool, unsigned int first)
+{
+    for (unsigned int i = first; i < pool->n; i++)
+        pool->started[i] = pthread_create(&pool->threads[i], NULL, ctr_worker, &pool->chunks[i]) == 0;
+}
+
+// the chunks whose threads failed to start are processed here
+static void ctr_join(ctr_pool_t *pool, unsigned int first)
+{
+    for (unsigned int i = first; i < pool->n; i++)
+    {
+        if (pool->started[i])
+            pthread_join(pool->threads[i], NULL);
+        else
+            ctr_worker(&pool->chunks[i]);
+    }
+}
+
+static unsigned int workers_for(unsigned int nthreads, size_t len)
+{
+    if (nthreads > EAX128_MT_MAX_THREADS)
+        nthreads = EAX128_MT_MAX_THREADS;
+
+    if (nthreads > len / EAX128_MT_MIN_CHUNK)
+        nthreads = len / EAX128_MT_MIN_CHUNK;
+
+    return nthreads;
+}
+
+void eax128_ctr_process_mt(const eax128_key_t *const keys[], unsigned int nthreads, const uint8_t nonce[16],
+                           uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    ctr_pool_t pool;
+
+    nthreads = workers_for(nthreads, len);
+
+    if (nthreads < 2)
+    {
+        chunk_t c = {keys[0], nonce, pos, in, out, len};
+        ctr_worker(&c);
+        return;
+    }
+
+    ctr_split(&pool, keys, nthreads, nonce, pos, in, out, len);
+
+    // the calling thread does the first chunk itself
+    ctr_start(&pool, 1);
+    ctr_worker(&pool.chunks[0]);
+    ctr_join(&pool, 1);
+}
+
+void eax128_crypt_buf_mt(const eax128_t *ctx, const eax128_key_t *const keys[], unsigned int nthreads,
+                         uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    const eax128_key_t *shared[EAX128_MT_MAX_THREADS];
+
+    if (!keys)
+    {
+        for (int i = 0; i < EAX128_MT_MAX_THREADS; i++)
+            shared[i] = ctx->ctr.key;
+        keys = shared;
+    }
+
+    eax128_ctr_process_mt(keys, nthreads, ctx->ctr.nonce.b, pos, in, out, len);
+}
+
+int eax128_decrypt_verify_mt(const eax128_key_t *const keys[], unsigned int nthreads,
+                             const uint8_t *nonce, unsigned int nonce_len,
+                             const uint8_t *header, size_t header_len,
+                             const uint8_t *ct, size_t len,
+                             const uint8_t *tag, unsigned int tag_len,
+                             uint8_t *pt)
+{
+    // the ct is read by the omac while the workers write the pt, can't overlap. no point for the small ones either
+    unsigned int workers = nthreads > 1 ? workers_for(nthreads - 1, len) : 0;
+
+    if (workers < 1 || pt == ct)
+    {
+        int res = eax128_decrypt_verify(keys[0], nonce, nonce_len, header, header_len, ct, len, tag, tag_len, pt);
+
+        // same staging contract, but the in-place ct is never wiped
+        if (res != 0 && pt != ct)
+            memset(pt, 0, len);
+        return res;
+    }
+
+    eax128_t ctx;
+    ctr_pool_t pool;
+    eax128_block_t local_tag;
+
+    // the nonce omac is the ctr start, so it goes first. the rest of the workers' keys follow the omac one
+    eax128_init(&ctx, keys[0], nonce, nonce_len);
+
+    ctr_split(&pool, keys + 1, workers, ctx.ctr.nonce.b, 0, ct, pt, len);
+    ctr_start(&pool, 0);
+
+    // meanwhile the serial chains here
+    eax128_auth_header_buf(&ctx, header, header_len);
+    eax128_auth_data_buf(&ctx, ct, len);
+    eax128_digest(&ctx, local_tag.b);
+
+    ctr_join(&pool, 0);
+
+    // constant time compare. the empty tag proves nothing
+    uint8_t diff = tag_len == 0 || tag_len > 16;
+    for (unsigned int i = 0; i < tag_len && i < 16; i++)
+        diff |= local_tag.b[i] ^ tag[i];
+
+    // the staging pt is released only if authentic
+    if (diff != 0)
+        memset(pt, 0, len);
+
+    eax128_clear(&ctx);
+    memset(&local_tag, 0, sizeof(local_tag));
+
+    return diff == 0 ? 0 : -1;
+}
@@ -0,0 +1,55 @@
+#ifndef _EAX128_MT_H_
+#define _EAX128_MT_H_
+
+#include "eax128.h"
+
+/*
+    Multi-threaded CTR for the large payloads (pthreads).
+
+    The CTR blocks are independent, so the range is split into the 16-aligned chunks, one per worker.
+    Each worker runs its own eax128_ctr_t starting at its chunk position, i.e. the counter offset is
+    nonce + pos / 16 via the usual add_ctr. The calling thread does the first chunk itself.
+    If the thread can't be started, its chunk is processed by the calling thread too, so the call never fails.
+
+    keys[i] is the key struct of the worker i (nthreads entries), so each worker may have its own cipher instance.
+    The keys must be initialized for the same AES key. eax128_crypt_buf_mt accepts keys == NULL, then all workers
+    share the ctx key, i.e. the cipher ctx must be read-only while encrypting (aes128_ctx_t, aes128ni, aes128bs,
+    aes128tt and eax128_aes are). The singleton aes128 store is not, use the per-worker keys for it.
+
+    The result is the same as of eax128_crypt_buf / eax128_ctr_process_buf. In place is fine.
+    The payloads below EAX128_MT_MIN_CHUNK per worker use fewer workers.
+
+    eax128_crypt_buf_mt is just the CTR, the OMAC of the ciphertext is still to be done (eax128_auth_data_buf).
+
+
+    eax128_decrypt_verify_mt is the eax128_decrypt_verify with the two stages overlapped: the calling thread runs
+    the serial header and data OMAC chains while nthreads - 1 workers produce the plaintext into pt by CTR.
+    So the latency of the big message is about the OMAC alone, not OMAC + CTR.
+    pt is the staging buffer: it's valid only if 0 is returned, and it's zeroed on the auth failure.
+    keys[0] is for the OMAC, keys[1 .. nthreads - 1] for the workers.
+    The in-place (pt == ct) and the small messages fall back to eax128_decrypt_verify, other overlaps of pt and ct
+    are not allowed. The in-place buffer is left untouched on the auth failure.
+*/
+
+#ifndef EAX128_MT_MAX_THREADS
+#define EAX128_MT_MAX_THREADS   64
+#endif
+
+#ifndef EAX128_MT_MIN_CHUNK
+#define EAX128_MT_MIN_CHUNK     (64 * 1024)
+#endif
+
+void eax128_ctr_process_mt(const eax128_key_t *const keys[], unsigned int nthreads, const uint8_t nonce[16],
+                           uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
+
+void eax128_crypt_buf_mt(const eax128_t *ctx, const eax128_key_t *const keys[], unsigned int nthreads,
+                         uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
+
+int eax128_decrypt_verify_mt(const eax128_key_t *const keys[], unsigned int nthreads,
+                             const uint8_t *nonce, unsigned int nonce_len,
+                             const uint8_t *header, size_t header_len,
+                             const uint8_t *ct, size_t len,
+                             const uint8_t *tag, unsigned int tag_len,
+                             uint8_t *pt);
+
+#endif
@@ -5,6 +5,30 @@
 #define BIG_CTR     0
 #define BIG_TAIL    0
 
+#ifndef USE_CIPHER_BLOCKS
+#define USE_CIPHER_BLOCKS 0     // use the user-provided multi-block cipher (pipelined, SIMD, etc)
+#endif
+
+#ifndef CTR_BATCH
+#define CTR_BATCH   8           // max blocks per multi-block cipher call
+#endif
+
+#ifndef BATCH_LANES
+#define BATCH_LANES 8           // messages processed in lockstep by eax64_verify_batch
+#endif
+
+static void cipher_blocks(void *cipher_ctx, uint64_t *blocks, unsigned int n)
+{
+    if (USE_CIPHER_BLOCKS)
+    {
+        eax64_cipher_blocks(cipher_ctx, blocks, n);
+        return;
+    }
+
+    for (unsigned int i = 0; i < n; i++)
+        blocks[i] = eax64_cipher(cipher_ctx, blocks[i]);
+}
+
 static uint64_t byterev64(uint64_t a)
 {
     return    (((a >>  0) & 0xff) << 56)
@@ -17,6 +41,19 @@ static uint64_t byterev64(uint64_t a)
             | (((a >> 56) & 0xff) <<  0);
 }
 
+// the data words. in and out may be unaligned
+static inline uint64_t ld64(const uint8_t *p)
+{
+    uint64_t q;
+    memcpy(&q, p, 8);
+    return q;
+}
+
+static inline void st64(uint8_t *p, uint64_t q)
+{
+    memcpy(p, &q, 8);
+}
+
 static uint64_t gf_double(uint64_t a)
 {
     if (BIG_TAIL)
@@ -30,78 +67,184 @@ static uint64_t gf_double(uint64_t a)
     return a;
 }
 
-void eax64_omac_init(eax64_omac_t *ctx, void *cipher_ctx, int k)
+void eax64_key_init(eax64_key_t *key, void *cipher_ctx)
+{
+    memset(key, 0, sizeof(eax64_key_t));
+    key->cipher_ctx = cipher_ctx;
+
+    // L = E(0)
+    key->l2 = gf_double(eax64_cipher(cipher_ctx, 0));
+    key->l4 = gf_double(key->l2);
+
+    // the tweak block is always the first one, so the omac state after it depends on key only.
+    // for the empty data it's the last one too
+    uint64_t pre[6];
+
+    for (int k = 0; k < 3; k++)
+    {
+        eax64_block_t t = {0};
+        t.b[7] = k;
+        pre[k] = t.q;
+        pre[3 + k] = t.q ^ key->l2;
+    }
+
+    // all six in a single batch
+    cipher_blocks(cipher_ctx, pre, 6);
+
+    memcpy(key->tweak, &pre[0], sizeof(key->tweak));
+    memcpy(key->empty, &pre[3], sizeof(key->empty));
+    memset(pre, 0, sizeof(pre));
+}
+
+void eax64_key_clear(eax64_key_t *key)
+{
+    memset(key, 0, sizeof(eax64_key_t));
+}
+
+
+void eax64_omac_init(eax64_omac_t *ctx, const eax64_key_t *key, int k)
 {
     memset(ctx, 0, sizeof(eax64_omac_t));
-    ctx->block.b[7] = k;
-    ctx->cipher_ctx = cipher_ctx;
+    ctx->mac = key->tweak[k];     // tweak block is already processed
+    ctx->k = k;
+    ctx->key = key;
 }
 
 void eax64_omac_process(eax64_omac_t *ctx, int byte)
 {
-    if (ctx->bytepos == 0)
+    if (ctx->bytepos == 8)
     {
-        ctx->mac = eax64_cipher(ctx->cipher_ctx, ctx->block.q ^ ctx->mac);
+        ctx->mac = eax64_cipher(ctx->key->cipher_ctx, ctx->block.q ^ ctx->mac);
         ctx->block.q = 0;
-
+        ctx->bytepos = 0;
     }
 
-    ctx->block.b[ctx->bytepos] = byte;
-    ctx->bytepos = (ctx->bytepos + 1) & 7;
+    ctx->block.b[ctx->bytepos++] = byte;
 }
 
 uint64_t eax64_omac_digest(eax64_omac_t *ctx)
 {
-    uint64_t tail = eax64_cipher(ctx->cipher_ctx, 0);
-    tail = gf_double(tail);
+    // no data, the result is precomputed
+    if (ctx->bytepos == 0)
+    {
+        ctx->mac = ctx->key->empty[ctx->k];
+        return ctx->mac;
+    }
+
+    uint64_t tail = ctx->key->l2;
 
-    if (ctx->bytepos != 0)
+    if (ctx->bytepos != 8)
     {
-        tail = gf_double(tail);
+        tail = ctx->key->l4;
         ctx->block.b[ctx->bytepos] = 0x80;
     }
 
-    ctx->mac = eax64_cipher(ctx->cipher_ctx, ctx->block.q ^ tail ^ ctx->mac);
+    ctx->mac = eax64_cipher(ctx->key->cipher_ctx, ctx->block.q ^ tail ^ ctx->mac);
 
     return ctx->mac;
 }
 
+void eax64_omac_process_buf(eax64_omac_t *ctx, const uint8_t *data, size_t len)
+{
+    // complete the partial block byte-by-byte
+    while (len && (ctx->bytepos % 8) != 0)
+    {
+        eax64_omac_process(ctx, *data++);
+        len--;
+    }
+
+    // the pending block is either empty or full here. absorb it and take the next one as a whole
+    while (len >= 8)
+    {
+        if (ctx->bytepos == 8)
+            ctx->mac = eax64_cipher(ctx->key->cipher_ctx, ctx->block.q ^ ctx->mac);
+
+        ctx->block.q = ld64(data);
+        ctx->bytepos = 8;
+        data += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        eax64_omac_process(ctx, *data++);
+}
+
 void eax64_omac_clear(eax64_omac_t *ctx)
 {
     memset(ctx, 0, sizeof(eax64_omac_t));
 }
 
 
-void eax64_ctr_init(eax64_ctr_t *ctx, void *cipher_ctx, uint64_t nonce)
+void eax64_ctr_init(eax64_ctr_t *ctx, const eax64_key_t *key, uint64_t nonce)
 {
     memset(ctx, 0, sizeof(eax64_ctr_t));
     ctx->nonce = nonce;
     ctx->blocknum = -1;    // something nonzero
-    ctx->cipher_ctx = cipher_ctx;
+    ctx->key = key;
 }
 
-int eax64_ctr_process(eax64_ctr_t *ctx, int pos, int byte)
+static uint64_t add_ctr(uint64_t nonce, uint64_t blocknum)
 {
-    int blocknum = pos / 8;
+    if (BIG_TAIL)
+        nonce = byterev64(nonce);
+
+    nonce += blocknum;
+
+    if (BIG_TAIL)
+        nonce = byterev64(nonce);
+
+    return nonce;
+}
+
+int eax64_ctr_process(eax64_ctr_t *ctx, uint64_t pos, int byte)
+{
+    uint64_t blocknum = pos / 8;
     if (blocknum != ctx->blocknum)    // change of block
     {
         ctx->blocknum = blocknum;
+        ctx->xorbuf.q = eax64_cipher(ctx->key->cipher_ctx, add_ctr(ctx->nonce, blocknum));
+    }
 
-        uint64_t a = ctx->nonce;
-
-        if (BIG_TAIL)
-            a = byterev64(a);
-
-        a += blocknum;
+    return ctx->xorbuf.b[pos % 8] ^ byte;
 
-        if (BIG_TAIL)
-            a = byterev64(a);
+}
 
-        ctx->xorbuf.q = eax64_cipher(ctx->cipher_ctx, a);
+void eax64_ctr_process_buf(eax64_ctr_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    // unaligned head
+    while (len && (pos % 8) != 0)
+    {
+        *out++ = eax64_ctr_process(ctx, pos++, *in++);
+        len--;
     }
 
-    return ctx->xorbuf.b[pos % 8] ^ byte;
+    while (len >= 8)
+    {
+        uint64_t ks[CTR_BATCH];
+        uint64_t blocknum = pos / 8;
+        unsigned int n = len / 8 < CTR_BATCH ? len / 8 : CTR_BATCH;
+
+        for (unsigned int i = 0; i < n; i++)
+            ks[i] = add_ctr(ctx->nonce, blocknum + i);
+        cipher_blocks(ctx->key->cipher_ctx, ks, n);
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            st64(out, ld64(in) ^ ks[i]);
+            in += 8;
+            out += 8;
+        }
+
+        // keep the last block for the following byte calls
+        ctx->xorbuf.q = ks[n - 1];
+        ctx->blocknum = blocknum + n - 1;
+
+        pos += n * 8;
+        len -= n * 8;
+    }
 
+    while (len--)
+        *out++ = eax64_ctr_process(ctx, pos++, *in++);
 }
 
 void eax64_ctr_clear(eax64_ctr_t *ctx)
@@ -109,19 +252,29 @@ void eax64_ctr_clear(eax64_ctr_t *ctx)
     memset(ctx, 0, sizeof(eax64_ctr_t));
 }
 
-void eax64_init(eax64_t *ctx, void *cipher_ctx, const uint8_t *nonce, int nonce_len)
+void eax64_init(eax64_t *ctx, const eax64_key_t *key, const uint8_t *nonce, int nonce_len)
+{
+    ctx->ctr.key = key;
+    eax64_reset(ctx, nonce, nonce_len);
+}
+
+void eax64_reset(eax64_t *ctx, const uint8_t *nonce, int nonce_len)
 {
+    // the ctr keeps the key pointer between messages (the digest clears the omacs only)
+    const eax64_key_t *key = ctx->ctr.key;
+
     // reuse header omac to avoid stack
     eax64_omac_t *nonceomac = &ctx->homac;
-    eax64_omac_init(nonceomac, cipher_ctx, 0);
-    for (int i = 0; i < nonce_len; i++)
-        eax64_omac_process(nonceomac, nonce[i]);
+    eax64_omac_init(nonceomac, key, 0);
+    eax64_omac_process_buf(nonceomac, nonce, nonce_len);
     uint64_t n = eax64_omac_digest(nonceomac);
-    eax64_ctr_init(&ctx->ctr, cipher_ctx, n);
+    eax64_ctr_init(&ctx->ctr, key, n);
 
     // this init will clear noncemac too
-    eax64_omac_init(&ctx->homac, cipher_ctx, 1);
-    eax64_omac_init(&ctx->domac, cipher_ctx, 2);
+    eax64_omac_init(&ctx->homac, key, 1);
+    eax64_omac_init(&ctx->domac, key, 2);
+
+    ctx->encpos = 0;
 }
 
 
@@ -135,11 +288,95 @@ void eax64_auth_header(eax64_t *ctx, int byte)
     eax64_omac_process(&ctx->homac, byte);
 }
 
-int eax64_crypt_data(eax64_t *ctx, int pos, int byte)
+int eax64_crypt_data(eax64_t *ctx, uint64_t pos, int byte)
 {
     return eax64_ctr_process(&ctx->ctr, pos, byte);
 }
 
+void eax64_auth_data_buf(eax64_t *ctx, const uint8_t *data, size_t len)
+{
+    eax64_omac_process_buf(&ctx->domac, data, len);
+}
+
+void eax64_auth_header_buf(eax64_t *ctx, const uint8_t *data, size_t len)
+{
+    eax64_omac_process_buf(&ctx->homac, data, len);
+}
+
+void eax64_crypt_buf(eax64_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len)
+{
+    eax64_ctr_process_buf(&ctx->ctr, pos, in, out, len);
+}
+
+void eax64_encrypt_update(eax64_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+    eax64_omac_t *omac = &ctx->domac;
+    eax64_ctr_t *ctr = &ctx->ctr;
+    uint64_t pos = ctx->encpos;
+
+    ctx->encpos += len;
+
+    // bytewise until both the ctr and omac are at the block boundary
+    while (len && ((pos % 8) != 0 || (omac->bytepos % 8) != 0))
+    {
+        int c = eax64_ctr_process(ctr, pos++, *in++);
+        eax64_omac_process(omac, c);
+        *out++ = c;
+        len--;
+    }
+
+    // the fused loop, see eax128_encrypt_update. the keystream group goes to the cipher with the pending omac block.
+    // it takes the batch of 2 at least, otherwise it's all the bytewise tail below
+    while (CTR_BATCH >= 2 && len >= 8)
+    {
+        uint64_t batch[CTR_BATCH];
+        uint64_t *ks = &batch[1];
+        uint64_t blocknum = pos / 8;
+        unsigned int n = len / 8 < CTR_BATCH - 1 ? len / 8 : CTR_BATCH - 1;
+        int absorb = omac->bytepos == 8;
+
+        batch[0] = omac->mac ^ omac->block.q;
+        for (unsigned int i = 0; i < n; i++)
+            ks[i] = add_ctr(ctr->nonce, blocknum + i);
+
+        if (absorb)
+        {
+            cipher_blocks(omac->key->cipher_ctx, batch, n + 1);
+            omac->mac = batch[0];
+        }
+        else
+        {
+            cipher_blocks(omac->key->cipher_ctx, ks, n);
+        }
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            if (i != 0)
+                omac->mac = eax64_cipher(omac->key->cipher_ctx, omac->mac ^ omac->block.q);
+
+            omac->block.q = ld64(in) ^ ks[i];
+            st64(out, omac->block.q);
+
+            in += 8;
+            out += 8;
+        }
+        omac->bytepos = 8;
+
+        ctr->xorbuf.q = ks[n - 1];
+        ctr->blocknum = blocknum + n - 1;
+
+        pos += n * 8;
+        len -= n * 8;
+    }
+
+    while (len--)
+    {
+        int c = eax64_ctr_process(ctr, pos++, *in++);
+        eax64_omac_process(omac, c);
+        *out++ = c;
+    }
+}
+
 uint64_t eax64_digest(eax64_t *ctx)
 {
     uint64_t c = eax64_omac_digest(&ctx->domac);
@@ -152,6 +389,159 @@ uint64_t eax64_digest(eax64_t *ctx)
     return tag;
 }
 
+int eax64_decrypt_verify(const eax64_key_t *key,
+                         const uint8_t *nonce, int nonce_len,
+                         const uint8_t *header, size_t header_len,
+                         const uint8_t *ct, size_t len,
+                         const uint8_t *tag, int tag_len,
+                         uint8_t *pt)
+{
+    eax64_t ctx;
+    eax64_block_t local_tag;
+
+    eax64_init(&ctx, key, nonce, nonce_len);
+    eax64_auth_header_buf(&ctx, header, header_len);
+    eax64_auth_data_buf(&ctx, ct, len);
+    local_tag.q = eax64_digest(&ctx);
+
+    // constant-time compare. the empty tag proves nothing
+    uint8_t diff = tag_len <= 0 || tag_len > 8;
+    for (int i = 0; i < tag_len && i < 8; i++)
+        diff |= local_tag.b[i] ^ tag[i];
+
+    if (diff == 0)
+        eax64_crypt_buf(&ctx, 0, ct, pt, len);
+
+    eax64_clear(&ctx);
+    local_tag.q = 0;
+
+    return diff == 0 ? 0 : -1;
+}
+
+// the omac over the complete buffer, see eax128.c
+typedef struct
+{
+    uint64_t mac;
+    const uint8_t *data;
+    size_t len;             // bytes left
+} omac_chain_t;
+
+static void chain_init(omac_chain_t *c, const eax64_key_t *key, int k, const uint8_t *data, size_t len)
+{
+    c->mac = len ? key->tweak[k] : key->empty[k];
+    c->data = data;
+    c->len = len;
+}
+
+// prepare the next cipher input of the chain. returns 0 if the chain is done
+static int chain_load(omac_chain_t *c, const eax64_key_t *key, uint64_t *dst)
+{
+    eax64_block_t block;
+
+    if (c->len == 0)
+        return 0;
+
+    if (c->len > 8)
+    {
+        *dst = c->mac ^ ld64(c->data);
+        c->data += 8;
+        c->len -= 8;
+        return 1;
+    }
+
+    // the last block
+    block.q = 0;
+    memcpy(block.b, c->data, c->len);
+    if (c->len != 8)
+        block.b[c->len] = 0x80;
+
+    *dst = c->mac ^ block.q ^ (c->len == 8 ? key->l2 : key->l4);
+    c->len = 0;
+    return 1;
+}
+
+void eax64_verify_batch(const eax64_key_t *key, const eax64_msg_t *msgs, unsigned int n, uint8_t *ok)
+{
+    struct
+    {
+        const eax64_msg_t *msg;
+        unsigned int idx;
+        omac_chain_t chains[3];
+    } lanes[BATCH_LANES];
+
+    uint64_t batch[3 * BATCH_LANES];
+    omac_chain_t *owner[3 * BATCH_LANES];
+    unsigned int next = 0;
+    unsigned int active = 0;
+
+    memset(ok, 0, (n + 7) / 8);
+
+    for (int l = 0; l < BATCH_LANES; l++)
+        lanes[l].msg = NULL;
+
+    // the lanes of eax128_verify_batch: a cipher call gets a block of each chain of each lane
+    while (1)
+    {
+        unsigned int nb = 0;
+
+        for (int l = 0; l < BATCH_LANES; l++)
+        {
+            if (!lanes[l].msg && next < n)
+            {
+                const eax64_msg_t *m = &msgs[next];
+                lanes[l].msg = m;
+                lanes[l].idx = next++;
+                chain_init(&lanes[l].chains[0], key, 0, m->nonce, m->nonce_len);
+                chain_init(&lanes[l].chains[1], key, 1, m->header, m->header_len);
+                chain_init(&lanes[l].chains[2], key, 2, m->ct, m->len);
+                active++;
+            }
+
+            if (!lanes[l].msg)
+                continue;
+
+            for (int i = 0; i < 3; i++)
+            {
+                if (chain_load(&lanes[l].chains[i], key, &batch[nb]))
+                    owner[nb++] = &lanes[l].chains[i];
+            }
+        }
+
+        if (nb)
+            cipher_blocks(key->cipher_ctx, batch, nb);
+
+        for (unsigned int i = 0; i < nb; i++)
+            owner[i]->mac = batch[i];
+
+        for (int l = 0; l < BATCH_LANES; l++)
+        {
+            omac_chain_t *c = lanes[l].chains;
+            const eax64_msg_t *m = lanes[l].msg;
+
+            if (!m || c[0].len || c[1].len || c[2].len)
+                continue;
+
+            eax64_block_t local_tag;
+            local_tag.q = c[0].mac ^ c[1].mac ^ c[2].mac;
+
+            uint8_t diff = m->tag_len <= 0 || m->tag_len > 8;
+            for (int i = 0; i < m->tag_len && i < 8; i++)
+                diff |= local_tag.b[i] ^ m->tag[i];
+
+            ok[lanes[l].idx / 8] |= (diff == 0) << (lanes[l].idx % 8);
+
+            lanes[l].msg = NULL;
+            active--;
+        }
+
+        if (!active && next >= n)
+            break;
+    }
+
+    memset(lanes, 0, sizeof(lanes));
+    memset(batch, 0, sizeof(batch));
+}
+
 void eax64_clear(eax64_t *ctx)
 {
     memset(ctx, 0, sizeof(eax64_t));
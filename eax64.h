@@ -1,9 +1,14 @@
 #ifndef _EAX64_H_
 #define _EAX64_H_
 
+#include <stddef.h>
+
 /*
     See eax128.h for generic comments on usage.
-    The 64-bit version is almost the same
+    The 64-bit version is almost the same.
+    The positions and block counters are 64-bit, the buffer lengths are size_t.
+    The *_buf and eax64_encrypt_update work on the whole 8-byte words (little-endian hosts only, like the rest)
+    eax64_verify_batch is the eax128_verify_batch, with BATCH_LANES in eax64.c
 */
 
 typedef union
@@ -15,44 +20,92 @@ typedef union
 typedef struct
 {
     void *cipher_ctx;
+    uint64_t l2;        // L * 2, L = E(0)
+    uint64_t l4;        // L * 4
+    uint64_t tweak[3];  // E([k]), the omac state after the tweak block
+    uint64_t empty[3];  // E([k] ^ L * 2), the omac of empty data
+} eax64_key_t;
+
+typedef struct
+{
+    const eax64_key_t *key;
     uint64_t mac;
-    eax64_block_t block;
-    int bytepos;
+    eax64_block_t block;    // the last block is kept until more data or digest
+    int bytepos;            // bytes in block, 0 - 8
+    int k;
 } eax64_omac_t;
 
 typedef struct
 {
-    void *cipher_ctx;
+    const eax64_key_t *key;
     uint64_t nonce;
     eax64_block_t xorbuf;
-    int blocknum;
+    uint64_t blocknum;
 } eax64_ctr_t;
 
+// message descriptor for the eax64_verify_batch
+typedef struct
+{
+    const uint8_t *nonce;
+    int nonce_len;
+    const uint8_t *header;
+    size_t header_len;
+    const uint8_t *ct;
+    size_t len;
+    const uint8_t *tag;
+    int tag_len;
+} eax64_msg_t;
+
 typedef struct
 {
     eax64_omac_t domac;
     eax64_omac_t homac;
     eax64_ctr_t ctr;
+    uint64_t encpos;        // stream position of the eax64_encrypt_update
 } eax64_t;
 
 // The external cipher function to be linked.
 // ctx is the argument passed to cipher. i.e. it may be used to distinguish cipher instances
 extern uint64_t eax64_cipher(void *ctx, uint64_t pt);
 
-void eax64_init(eax64_t *ctx, void *cipher_ctx, const uint8_t *nonce, int nonce_len);
+// The optional multi-block cipher, the n blocks are processed in place.
+// The blocks are independent, so the pipelined or SIMD cipher may process them in parallel.
+// It's used if eax64.c is built with USE_CIPHER_BLOCKS=1, otherwise the blocks are passed to eax64_cipher one by one
+extern void eax64_cipher_blocks(void *ctx, uint64_t *blocks, unsigned int n);
+
+void eax64_key_init(eax64_key_t *key, void *cipher_ctx);
+void eax64_key_clear(eax64_key_t *key);
+
+void eax64_init(eax64_t *ctx, const eax64_key_t *key, const uint8_t *nonce, int nonce_len);
+void eax64_reset(eax64_t *ctx, const uint8_t *nonce, int nonce_len);
 void eax64_auth_data(eax64_t *ctx, int byte);
 void eax64_auth_header(eax64_t *ctx, int byte);
-int eax64_crypt_data(eax64_t *ctx, int pos, int byte);
+int eax64_crypt_data(eax64_t *ctx, uint64_t pos, int byte);
+void eax64_auth_data_buf(eax64_t *ctx, const uint8_t *data, size_t len);
+void eax64_auth_header_buf(eax64_t *ctx, const uint8_t *data, size_t len);
+void eax64_crypt_buf(eax64_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
+void eax64_encrypt_update(eax64_t *ctx, const uint8_t *in, uint8_t *out, size_t len);
 uint64_t eax64_digest(eax64_t *ctx);
 void eax64_clear(eax64_t *ctx);
 
+int eax64_decrypt_verify(const eax64_key_t *key,
+                         const uint8_t *nonce, int nonce_len,
+                         const uint8_t *header, size_t header_len,
+                         const uint8_t *ct, size_t len,
+                         const uint8_t *tag, int tag_len,
+                         uint8_t *pt);
+
+void eax64_verify_batch(const eax64_key_t *key, const eax64_msg_t *msgs, unsigned int n, uint8_t *ok);
+
 
-void eax64_omac_init(eax64_omac_t *ctx, void *cipher_ctx, int k);
+void eax64_omac_init(eax64_omac_t *ctx, const eax64_key_t *key, int k);
 void eax64_omac_process(eax64_omac_t *ctx, int byte);
+void eax64_omac_process_buf(eax64_omac_t *ctx, const uint8_t *data, size_t len);
 uint64_t eax64_omac_digest(eax64_omac_t *ctx);
 void eax64_omac_clear(eax64_omac_t *ctx);
-void eax64_ctr_init(eax64_ctr_t *ctx, void *cipher_ctx, uint64_t nonce);
-int eax64_ctr_process(eax64_ctr_t *ctx, int pos, int byte);
+void eax64_ctr_init(eax64_ctr_t *ctx, const eax64_key_t *key, uint64_t nonce);
+int eax64_ctr_process(eax64_ctr_t *ctx, uint64_t pos, int byte);
+void eax64_ctr_process_buf(eax64_ctr_t *ctx, uint64_t pos, const uint8_t *in, uint8_t *out, size_t len);
 void eax64_ctr_clear(eax64_ctr_t *ctx);
 
 #endif
@@ -0,0 +1,27 @@
+#include <stdint.h>
+#include "eax64.h"
+#include "speck64.h"
+
+#ifndef SPECK_VEC
+#define SPECK_VEC 0     // the multi-block hook is the SSE2/AVX2 code of speck64vec.c (x86)
+#endif
+
+#if SPECK_VEC
+#include "speck64vec.h"
+#endif
+
+// eax64 hooks. ctx is the speck64_key_t
+
+uint64_t eax64_cipher(void *ctx, uint64_t pt)
+{
+    return speck64_encrypt(ctx, pt);
+}
+
+void eax64_cipher_blocks(void *ctx, uint64_t *blocks, unsigned int n)
+{
+#if SPECK_VEC
+    speck64vec_encrypt_blocks(ctx, blocks, n);
+#else
+    speck64_encrypt_blocks(ctx, blocks, n);
+#endif
+}
@@ -0,0 +1,27 @@
+#include <stdint.h>
+#include "eax64.h"
+#include "xtea.h"
+
+#ifndef XTEA_VEC
+#define XTEA_VEC 0      // the multi-block hook is the SSE2/AVX2 code of xteavec.c (x86)
+#endif
+
+#if XTEA_VEC
+#include "xteavec.h"
+#endif
+
+// eax64 hooks. ctx is the xtea_key_t
+
+uint64_t eax64_cipher(void *ctx, uint64_t pt)
+{
+    return xtea_encrypt(ctx, pt);
+}
+
+void eax64_cipher_blocks(void *ctx, uint64_t *blocks, unsigned int n)
+{
+#if XTEA_VEC
+    xteavec_encrypt_blocks(ctx, blocks, n);
+#else
+    xtea_encrypt_blocks(ctx, blocks, n);
+#endif
+}
@@ -8,6 +8,92 @@
 
 #include "vectors_eax_aes.h"
 
+// build with USE_AESNI=1, USE_AESVAES=1, USE_AESBS=1 or USE_AESTT=1 to run all the tests on the AES-NI, VAES,
+// bitsliced or T-table backend. USE_DISPATCH=1 runs them on every backend the CPU supports via the eax128_aes dispatch
+#ifndef USE_AESNI
+#define USE_AESNI 0
+#endif
+
+#ifndef USE_AESBS
+#define USE_AESBS 0
+#endif
+
+#ifndef USE_AESVAES
+#define USE_AESVAES 0
+#endif
+
+#ifndef USE_AESTT
+#define USE_AESTT 0
+#endif
+
+#ifndef USE_DISPATCH
+#define USE_DISPATCH 0
+#endif
+
+// build with USE_MT=1 (and eax128_mt.c, pthreads) to test the multi-threaded CTR too. Needs a re-entrant backend
+#ifndef USE_MT
+#define USE_MT 0
+#endif
+
+#if USE_MT
+#include "eax128_mt.h"
+#endif
+
+#define USE_AES_BLOCKS (USE_AESNI || USE_AESVAES || USE_AESBS || USE_AESTT || USE_DISPATCH)
+
+#if USE_DISPATCH
+#include "eax128_aes.h"
+typedef eax128_aes_ctx_t aes_ctx_t;
+#define aes_ctx_set_key         eax128_aes_set_key
+#define aes_ctx_encrypt         eax128_aes_encrypt
+#define aes_ctx_encrypt_blocks  eax128_aes_encrypt_blocks
+#define aes_ctx_clear           eax128_aes_clear
+#elif USE_AESNI
+#include "aes128ni.h"
+typedef aes128ni_ctx_t aes_ctx_t;
+#define aes_ctx_set_key         aes128ni_set_key
+#define aes_ctx_encrypt         aes128ni_encrypt
+#define aes_ctx_encrypt_blocks  aes128ni_encrypt_blocks
+#define aes_ctx_clear           aes128ni_clear
+#elif USE_AESVAES
+#include "aes128vaes.h"
+typedef aes128ni_ctx_t aes_ctx_t;
+#define aes_ctx_set_key         aes128ni_set_key
+#define aes_ctx_encrypt         aes128ni_encrypt
+#define aes_ctx_encrypt_blocks  aes_vaes_encrypt_blocks
+#define aes_ctx_clear           aes128ni_clear
+
+// the same binary falls back to the AES-NI if there is no VAES
+static int have_vaes;
+
+static void aes_vaes_encrypt_blocks(const aes128ni_ctx_t *ctx, uint8_t *blocks, unsigned int n)
+{
+    if (have_vaes)
+        aes128vaes_encrypt_blocks(ctx, blocks, n);
+    else
+        aes128ni_encrypt_blocks(ctx, blocks, n);
+}
+#elif USE_AESBS
+#include "aes128bs.h"
+typedef aes128bs_ctx_t aes_ctx_t;
+#define aes_ctx_set_key         aes128bs_set_key
+#define aes_ctx_encrypt         aes128bs_encrypt
+#define aes_ctx_encrypt_blocks  aes128bs_encrypt_blocks
+#define aes_ctx_clear           aes128bs_clear
+#elif USE_AESTT
+#include "aes128tt.h"
+typedef aes128tt_ctx_t aes_ctx_t;
+#define aes_ctx_set_key         aes128tt_set_key
+#define aes_ctx_encrypt         aes128tt_encrypt
+#define aes_ctx_encrypt_blocks  aes128tt_encrypt_blocks
+#define aes_ctx_clear           aes128tt_clear
+#else
+typedef aes128_ctx_t aes_ctx_t;
+#define aes_ctx_set_key         aes128_ctx_set_key
+#define aes_ctx_encrypt         aes128_ctx_encrypt
+#define aes_ctx_clear           aes128_ctx_clear
+#endif
+
 static struct
 {
     uint32_t words[AES128_NREGS];
@@ -23,9 +109,20 @@ uint32_t aes128_ldreg(int i)
     return aes_regs.words[i];
 }
 
+static eax128_key_t eax_key;
+static aes_ctx_t aes_ctx;
+
 void aes_install_key(const uint8_t *key)
 {
+    if (USE_AES_BLOCKS)
+    {
+        aes_ctx_set_key(&aes_ctx, key);
+        eax128_key_init(&eax_key, &aes_ctx);
+        return;
+    }
+
     aes128_set_key(key);
+    eax128_key_init(&eax_key, NULL);
 }
 
 
@@ -46,20 +143,43 @@ void print_dump(const void *data, int len)
     printf("\n");
 }
 
+#if !USE_DISPATCH
+// ctx is the aes_ctx_t instance. NULL is for the singleton store
 extern void eax128_cipher(void *ctx, uint8_t block[16])
 {
+    if (ctx)
+    {
+        aes_ctx_encrypt(ctx, block);
+        return;
+    }
+
     aes128_set_data(block);
     aes128_encrypt();
     aes128_get_data(block);
 }
 
+extern void eax128_cipher_blocks(void *ctx, uint8_t *blocks, unsigned int n)
+{
+#if USE_AES_BLOCKS
+    if (ctx)
+    {
+        aes_ctx_encrypt_blocks(ctx, blocks, n);
+        return;
+    }
+#endif
+
+    for (unsigned int i = 0; i < n; i++)
+        eax128_cipher(ctx, &blocks[i * 16]);
+}
+#endif
+
 static void test_vector(const testvector_t *v)
 {
     eax128_t ctx;
 
     aes_install_key(v->key);
 
-    eax128_init(&ctx, NULL, v->nonce, v->noncelen);
+    eax128_init(&ctx, &eax_key, v->nonce, v->noncelen);
 
     uint8_t pt[256];
 
@@ -94,6 +214,486 @@ static void test_vector(const testvector_t *v)
     }
 }
 
+// same as above, but via the bulk functions mixed with the byte ones
+static void test_vector_buf(const testvector_t *v)
+{
+    eax128_t ctx;
+
+    aes_install_key(v->key);
+
+    eax128_init(&ctx, &eax_key, v->nonce, v->noncelen);
+
+    uint8_t pt[256];
+
+    // split at some odd point to get the unaligned heads and tails
+    int hsplit = v->headerlen / 3;
+    int csplit = v->ctlen / 3;
+
+    for (int i = 0; i < hsplit; i++)
+        eax128_auth_header(&ctx, v->header[i]);
+    eax128_auth_header_buf(&ctx, &v->header[hsplit], v->headerlen - hsplit);
+
+    eax128_auth_data_buf(&ctx, v->ct, csplit);
+    for (int i = csplit; i < v->ctlen; i++)
+        eax128_auth_data(&ctx, v->ct[i]);
+
+    memcpy(pt, v->ct, v->ctlen);
+    eax128_crypt_buf(&ctx, 0, pt, pt, csplit);
+    eax128_crypt_buf(&ctx, csplit, &pt[csplit], &pt[csplit], v->ctlen - csplit);
+
+    uint8_t local_tag[16];
+    eax128_digest(&ctx, local_tag);
+
+    if (memcmp(pt, v->pt, v->ptlen) != 0)
+    {
+        print_dump(pt, v->ptlen);
+        print_dump(v->pt, v->ptlen);
+        printf("buf decrypt fail\n");
+        exit(-1);
+    }
+
+    if (memcmp(local_tag, v->tag, v->taglen) != 0)
+    {
+        print_dump(v->tag, v->taglen);
+        print_dump(local_tag, v->taglen);
+        printf("buf auth fail\n");
+        exit(-1);
+    }
+}
+
+static void test_vector_encrypt(const testvector_t *v)
+{
+    eax128_t ctx;
+
+    aes_install_key(v->key);
+
+    eax128_init(&ctx, &eax_key, v->nonce, v->noncelen);
+    eax128_auth_header_buf(&ctx, v->header, v->headerlen);
+
+    uint8_t ct[256];
+
+    // odd-sized pieces to exercise the unaligned paths
+    int pos = 0;
+    int piece = 1;
+    while (pos < v->ptlen)
+    {
+        int n = v->ptlen - pos < piece ? v->ptlen - pos : piece;
+        eax128_encrypt_update(&ctx, &v->pt[pos], &ct[pos], n);
+        pos += n;
+        piece += 13;
+    }
+
+    uint8_t local_tag[16];
+    eax128_digest(&ctx, local_tag);
+
+    if (memcmp(ct, v->ct, v->ctlen) != 0)
+    {
+        print_dump(ct, v->ctlen);
+        print_dump(v->ct, v->ctlen);
+        printf("encrypt fail\n");
+        exit(-1);
+    }
+
+    if (memcmp(local_tag, v->tag, v->taglen) != 0)
+    {
+        print_dump(v->tag, v->taglen);
+        print_dump(local_tag, v->taglen);
+        printf("encrypt auth fail\n");
+        exit(-1);
+    }
+}
+
+static void test_vector_verify(const testvector_t *v)
+{
+    uint8_t pt[256];
+    uint8_t tag[16];
+
+    aes_install_key(v->key);
+
+    memset(pt, 0xAA, sizeof(pt));
+    if (eax128_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                              v->ct, v->ctlen, v->tag, v->taglen, pt) != 0)
+    {
+        printf("verify fail\n");
+        exit(-1);
+    }
+
+    if (memcmp(pt, v->pt, v->ptlen) != 0)
+    {
+        print_dump(pt, v->ptlen);
+        print_dump(v->pt, v->ptlen);
+        printf("verify decrypt fail\n");
+        exit(-1);
+    }
+
+    // in place
+    memcpy(pt, v->ct, v->ctlen);
+    if (eax128_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                              pt, v->ctlen, v->tag, v->taglen, pt) != 0 || memcmp(pt, v->pt, v->ptlen) != 0)
+    {
+        printf("verify in place fail\n");
+        exit(-1);
+    }
+
+    // broken and empty tags should be rejected, the separate plaintext zeroed and nothing written past it
+    memcpy(tag, v->tag, v->taglen);
+    tag[v->taglen - 1] ^= 1;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        memset(pt, 0xAA, sizeof(pt));
+        if (eax128_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                                  v->ct, v->ctlen, pass ? v->tag : tag, pass ? 0 : v->taglen, pt) == 0)
+        {
+            printf("verify broken tag fail\n");
+            exit(-1);
+        }
+
+        for (int i = 0; i < sizeof(pt); i++)
+        {
+            if (pt[i] != (i < v->ctlen ? 0 : 0xAA))
+            {
+                printf("verify leaked plaintext\n");
+                exit(-1);
+            }
+        }
+    }
+
+    // in place the ciphertext is left untouched
+    memcpy(pt, v->ct, v->ctlen);
+    if (eax128_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                              pt, v->ctlen, tag, v->taglen, pt) == 0 || memcmp(pt, v->ct, v->ctlen) != 0)
+    {
+        printf("verify in place leaked plaintext\n");
+        exit(-1);
+    }
+}
+
+// two independent instances with the different keys running at once
+static void test_vector_pair(const testvector_t *v0, const testvector_t *v1)
+{
+    const testvector_t *v[2] = {v0, v1};
+    aes_ctx_t aes[2];
+    eax128_key_t key[2];
+    eax128_t ctx[2];
+    uint8_t pt[2][256];
+    uint8_t local_tag[2][16];
+
+    for (int j = 0; j < 2; j++)
+    {
+        aes_ctx_set_key(&aes[j], v[j]->key);
+        eax128_key_init(&key[j], &aes[j]);
+        eax128_init(&ctx[j], &key[j], v[j]->nonce, v[j]->noncelen);
+    }
+
+    for (int i = 0; i < 256; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            if (i < v[j]->headerlen)
+                eax128_auth_header(&ctx[j], v[j]->header[i]);
+            if (i < v[j]->ctlen)
+            {
+                eax128_auth_data(&ctx[j], v[j]->ct[i]);
+                pt[j][i] = eax128_crypt_data(&ctx[j], i, v[j]->ct[i]);
+            }
+        }
+    }
+
+    for (int j = 0; j < 2; j++)
+    {
+        eax128_digest(&ctx[j], local_tag[j]);
+
+        if (memcmp(pt[j], v[j]->pt, v[j]->ptlen) != 0 || memcmp(local_tag[j], v[j]->tag, v[j]->taglen) != 0)
+        {
+            printf("pair fail\n");
+            exit(-1);
+        }
+
+        aes_ctx_clear(&aes[j]);
+    }
+}
+
+// messages of the vectors reencrypted under the same key, with some of them broken
+static void test_verify_batch(void)
+{
+    enum { NMSGS = 61 };
+    static eax128_msg_t msgs[NMSGS];
+    static uint8_t ct[NMSGS][256];
+    static uint8_t tags[NMSGS][16];
+    uint8_t ok[(NMSGS + 7) / 8];
+
+    aes_install_key(testvectors[0].key);
+
+    for (int i = 0; i < NMSGS; i++)
+    {
+        const testvector_t *v = &testvectors[i];
+        eax128_t ctx;
+
+        eax128_init(&ctx, &eax_key, v->nonce, v->noncelen);
+        eax128_auth_header_buf(&ctx, v->header, v->headerlen);
+        eax128_encrypt_update(&ctx, v->pt, ct[i], v->ptlen);
+        eax128_digest(&ctx, tags[i]);
+
+        // every third is broken, either the ciphertext or tag
+        if (i % 3 == 1)
+        {
+            if (v->ptlen && i % 2)
+                ct[i][v->ptlen - 1] ^= 0x10;
+            else
+                tags[i][i % 16] ^= 0x01;
+        }
+
+        msgs[i] = (eax128_msg_t){v->nonce, v->noncelen, v->header, v->headerlen, ct[i], v->ptlen, tags[i], 16};
+    }
+
+    eax128_verify_batch(&eax_key, msgs, NMSGS, ok);
+
+    for (int i = 0; i < NMSGS; i++)
+    {
+        if (((ok[i / 8] >> (i % 8)) & 1) != (i % 3 != 1))
+        {
+            printf("batch fail %d\n", i);
+            exit(-1);
+        }
+    }
+
+    // the empty tag is never authentic
+    msgs[0].tag_len = 0;
+    eax128_verify_batch(&eax_key, msgs, 1, ok);
+    if (ok[0] & 1)
+    {
+        printf("batch empty tag fail\n");
+        exit(-1);
+    }
+}
+
+// the compact context should give the same ciphertext and tag, for any split of the data
+static void test_compact(const testvector_t *v)
+{
+    eax128c_t ctx;
+    uint8_t buf[256];
+    uint8_t tag[16];
+
+    // the documented size target
+    if (sizeof(void *) == 8 && sizeof(eax128c_t) != 64)
+    {
+        printf("compact size fail %d\n", (int)sizeof(eax128c_t));
+        exit(-1);
+    }
+
+    aes_install_key(v->key);
+
+    // odd-sized pieces to exercise the unaligned paths
+    eax128c_init(&ctx, &eax_key, v->nonce, v->noncelen, v->header, v->headerlen);
+    int pos = 0;
+    int piece = 1;
+    while (pos < v->ptlen)
+    {
+        int n = v->ptlen - pos < piece ? v->ptlen - pos : piece;
+        eax128c_encrypt_update(&ctx, &v->pt[pos], &buf[pos], n);
+        pos += n;
+        piece += 7;
+    }
+    eax128c_digest(&ctx, tag);
+
+    if (memcmp(buf, v->ct, v->ctlen) != 0 || memcmp(tag, v->tag, v->taglen) != 0)
+    {
+        printf("compact encrypt fail\n");
+        exit(-1);
+    }
+
+    // decrypt in place, the ctr pieces out of order
+    int split = v->ctlen / 3;
+
+    eax128c_reset(&ctx, v->nonce, v->noncelen, v->header, v->headerlen);
+    eax128c_auth_data_buf(&ctx, v->ct, split);
+    eax128c_auth_data_buf(&ctx, &v->ct[split], v->ctlen - split);
+    eax128c_digest(&ctx, tag);
+
+    memcpy(buf, v->ct, v->ctlen);
+    eax128c_crypt_buf(&ctx, split, &buf[split], &buf[split], v->ctlen - split);
+    eax128c_crypt_buf(&ctx, 0, buf, buf, split);
+
+    if (memcmp(buf, v->pt, v->ptlen) != 0 || memcmp(tag, v->tag, v->taglen) != 0)
+    {
+        printf("compact decrypt fail\n");
+        exit(-1);
+    }
+
+    eax128c_clear(&ctx);
+}
+
+// a context reset for the each next message should match the freshly inited ones, even if the previous message is dropped midway
+static void test_reset(void)
+{
+    eax128_t ctx;
+
+    aes_install_key(testvectors[0].key);
+    eax128_init(&ctx, &eax_key, testvectors[0].nonce, testvectors[0].noncelen);
+
+    for (int i = 0; i < 20; i++)
+    {
+        const testvector_t *v = &testvectors[i];
+        uint8_t ct[256], ref_ct[256];
+        uint8_t tag[16], ref_tag[16];
+        eax128_t ref;
+
+        eax128_init(&ref, &eax_key, v->nonce, v->noncelen);
+        eax128_auth_header_buf(&ref, v->header, v->headerlen);
+        eax128_encrypt_update(&ref, v->pt, ref_ct, v->ptlen);
+        eax128_digest(&ref, ref_tag);
+
+        // start a message and drop it
+        if (i % 4 == 3)
+        {
+            eax128_reset(&ctx, v->header, v->headerlen);
+            eax128_auth_header_buf(&ctx, v->pt, v->ptlen);
+            eax128_encrypt_update(&ctx, v->header, ct, v->headerlen);
+        }
+
+        eax128_reset(&ctx, v->nonce, v->noncelen);
+        eax128_auth_header_buf(&ctx, v->header, v->headerlen);
+        eax128_encrypt_update(&ctx, v->pt, ct, v->ptlen);
+        eax128_digest(&ctx, tag);
+
+        if (memcmp(ct, ref_ct, v->ptlen) != 0 || memcmp(tag, ref_tag, 16) != 0)
+        {
+            printf("reset fail %d\n", i);
+            exit(-1);
+        }
+    }
+
+    eax128_clear(&ctx);
+}
+
+// the stream positions are 64-bit: the keystream past 2^32 blocks must be E(N + blocknum), N + blocknum is 128-bit BE
+static void test_ctr_64(const testvector_t *v)
+{
+    static const uint64_t firsts[] = {(1ULL << 32) - 2, (1ULL << 36) + 5, (1ULL << 59) - 3};
+    aes128_ctx_t ref;
+    eax128_t ctx;
+
+    aes_install_key(v->key);
+    aes128_ctx_set_key(&ref, v->key);
+    eax128_init(&ctx, &eax_key, v->nonce, v->noncelen);
+
+    for (int f = 0; f < sizeof(firsts) / sizeof(firsts[0]); f++)
+    {
+        uint8_t ks[4][16];
+        uint8_t expected[4][16];
+
+        for (int b = 0; b < 4; b++)
+        {
+            uint64_t inc = firsts[f] + b;
+            unsigned int c = 0;
+
+            for (int i = 15; i >= 0; i--)
+            {
+                c += ctx.ctr.nonce.b[i] + (inc & 0xFF);
+                expected[b][i] = c;
+                c >>= 8;
+                inc >>= 8;
+            }
+            aes128_ctx_encrypt(&ref, expected[b]);
+        }
+
+        memset(ks, 0, sizeof(ks));
+        eax128_crypt_buf(&ctx, firsts[f] * 16, ks[0], ks[0], sizeof(ks));
+        if (memcmp(ks, expected, sizeof(ks)) != 0)
+        {
+            printf("ctr 64 buf failed\n");
+            exit(-1);
+        }
+
+        for (int i = 0; i < sizeof(ks); i++)
+        {
+            if (eax128_crypt_data(&ctx, firsts[f] * 16 + i, 0) != expected[i / 16][i % 16])
+            {
+                printf("ctr 64 failed\n");
+                exit(-1);
+            }
+        }
+    }
+
+    eax128_clear(&ctx);
+}
+
+#if USE_CUSTOM_MATH128
+extern void _add128be_64le(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+extern void _add128le_64le(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+extern void _gf_double_128be(uint32_t dst[4], const uint32_t src[4], int n);
+extern void _gf_double_128le(uint32_t dst[4], const uint32_t src[4], int n);
+extern void _xor128(uint32_t dst[4], const uint32_t a[4], const uint32_t b[4]);
+
+static void reverse_block(eax128_block_t *dst, const eax128_block_t *src)
+{
+    for (int i = 0; i < 16; i++)
+        dst->b[i] = src->b[15 - i];
+}
+
+// the be and le hooks must agree on the byte-reversed blocks, and the carries/reduction must hit the known values
+static void test_math128(void)
+{
+    eax128_block_t a, ar, be, le, ler;
+
+    memset(a.b, 0xFF, 16);
+    _add128be_64le(be.w, a.w, 1);
+    memset(a.b, 0, 16);
+    if (memcmp(be.b, a.b, 16) != 0)
+    {
+        printf("math128 add carry failed\n");
+        exit(-1);
+    }
+
+    a.b[0] = 0x80;
+    _gf_double_128be(be.w, a.w, 1);
+    a.b[0] = 0;
+    a.b[15] = 0x87;
+    if (memcmp(be.b, a.b, 16) != 0)
+    {
+        printf("math128 double reduction failed\n");
+        exit(-1);
+    }
+
+    for (int i = 0; i < 256; i++)
+    {
+        for (int j = 0; j < 16; j++)
+            a.b[j] = (j < i % 16) ? 0xFF : i * 37 + j * 101;
+        reverse_block(&ar, &a);
+
+        uint64_t inc = i * 0x0101010101010101ULL + 0xFFFFFFFFFFFFFF00ULL;
+
+        _add128be_64le(be.w, a.w, inc);
+        _add128le_64le(le.w, ar.w, inc);
+        reverse_block(&ler, &le);
+        if (memcmp(be.b, ler.b, 16) != 0)
+        {
+            printf("math128 add failed\n");
+            exit(-1);
+        }
+
+        _gf_double_128be(be.w, a.w, 1 + i % 3);
+        _gf_double_128le(le.w, ar.w, 1 + i % 3);
+        reverse_block(&ler, &le);
+        if (memcmp(be.b, ler.b, 16) != 0)
+        {
+            printf("math128 double failed\n");
+            exit(-1);
+        }
+
+        _xor128(be.w, a.w, ar.w);
+        for (int j = 0; j < 16; j++)
+        {
+            if (be.b[j] != (a.b[j] ^ ar.b[j]))
+            {
+                printf("math128 xor failed\n");
+                exit(-1);
+            }
+        }
+    }
+}
+#endif
+
 // special test to be sure the 64 bit nonce addition is running fine
 static void test_ctr_ovf(void)
 {
@@ -109,7 +709,7 @@ static void test_ctr_ovf(void)
     eax128_ctr_t ctr;
 
     aes_install_key(key);
-    eax128_ctr_init(&ctr, NULL, nonce);
+    eax128_ctr_init(&ctr, &eax_key, nonce);
 
     for (int i = 0; i < sizeof(pt); i++)
     {
@@ -122,13 +722,221 @@ static void test_ctr_ovf(void)
     }
 }
 
-int main(void)
+#if USE_AES_BLOCKS
+// multi-block call should match the portable single-block one for any count
+static void test_aes_blocks(void)
 {
+    aes128_ctx_t ref;
+    aes_ctx_t ctx;
+    uint8_t blocks[20][16];
+    uint8_t expected[20][16];
+
+    aes128_ctx_set_key(&ref, testvectors[5].key);
+    aes_ctx_set_key(&ctx, testvectors[5].key);
+
+    for (unsigned int n = 0; n <= 20; n++)
+    {
+        for (int i = 0; i < sizeof(blocks); i++)
+            blocks[i / 16][i % 16] = i * 7 + n;
+        memcpy(expected, blocks, sizeof(blocks));
+
+        for (unsigned int i = 0; i < n; i++)
+            aes128_ctx_encrypt(&ref, expected[i]);
+        aes_ctx_encrypt_blocks(&ctx, blocks[0], n);
+
+        if (memcmp(blocks, expected, sizeof(blocks)) != 0)
+        {
+            printf("aes blocks fail\n");
+            exit(-1);
+        }
+    }
+}
+#endif
+
+#if USE_MT
+// the threaded CTR should match the single-threaded one for any split, head alignment and worker keys
+static void test_crypt_mt(void)
+{
+    static uint8_t in[1024 * 1024 + 37];
+    static uint8_t out[sizeof(in)];
+    static uint8_t expected[sizeof(in)];
+    const eax128_key_t *keys[8];
+    eax128_t ctx;
+
+    aes_install_key(testvectors[5].key);
+    eax128_init(&ctx, &eax_key, testvectors[5].nonce, testvectors[5].noncelen);
+
+    for (int i = 0; i < 8; i++)
+        keys[i] = &eax_key;
+
+    for (int i = 0; i < sizeof(in); i++)
+        in[i] = i * 13 + (i >> 8);
+
+    for (unsigned int nthreads = 1; nthreads <= 8; nthreads++)
+    {
+        unsigned int pos = nthreads * 5;
+        unsigned int len = sizeof(in) - nthreads;
+
+        eax128_crypt_buf(&ctx, pos, in, expected, len);
+
+        memset(out, 0, sizeof(out));
+        eax128_crypt_buf_mt(&ctx, NULL, nthreads, pos, in, out, len);
+        if (memcmp(out, expected, len) != 0)
+        {
+            printf("crypt mt failed\n");
+            exit(-1);
+        }
+
+        memcpy(out, in, len);
+        eax128_crypt_buf_mt(&ctx, keys, nthreads, pos, out, out, len);
+        if (memcmp(out, expected, len) != 0)
+        {
+            printf("crypt mt in place failed\n");
+            exit(-1);
+        }
+    }
+
+    eax128_clear(&ctx);
+}
+
+// the overlapped omac/ctr verify should give the plaintext of the authentic message and nothing of the forged one
+static void test_decrypt_verify_mt(void)
+{
+    static uint8_t pt[512 * 1024 + 21];
+    static uint8_t ct[sizeof(pt)];
+    static uint8_t out[sizeof(pt)];
+    const testvector_t *v = &testvectors[5];
+    const eax128_key_t *keys[5];
+    uint8_t tag[16];
+    eax128_t ctx;
+
+    aes_install_key(v->key);
+
+    for (int i = 0; i < 5; i++)
+        keys[i] = &eax_key;
+
+    for (int i = 0; i < sizeof(pt); i++)
+        pt[i] = i * 7 + (i >> 9);
+
+    eax128_init(&ctx, &eax_key, v->nonce, v->noncelen);
+    eax128_auth_header_buf(&ctx, v->header, v->headerlen);
+    eax128_encrypt_update(&ctx, pt, ct, sizeof(pt));
+    eax128_digest(&ctx, tag);
+
+    for (unsigned int nthreads = 1; nthreads <= 5; nthreads++)
+    {
+        memset(out, 0xAA, sizeof(out));
+        if (eax128_decrypt_verify_mt(keys, nthreads, v->nonce, v->noncelen, v->header, v->headerlen, ct, sizeof(ct), tag, 16, out) != 0
+            || memcmp(out, pt, sizeof(pt)) != 0)
+        {
+            printf("decrypt verify mt failed\n");
+            exit(-1);
+        }
+
+        tag[nthreads] ^= 1;
+        memset(out, 0xAA, sizeof(out));
+        if (eax128_decrypt_verify_mt(keys, nthreads, v->nonce, v->noncelen, v->header, v->headerlen, ct, sizeof(ct), tag, 16, out) != -1)
+        {
+            printf("decrypt verify mt forged\n");
+            exit(-1);
+        }
+        tag[nthreads] ^= 1;
+
+        if (eax128_decrypt_verify_mt(keys, nthreads, v->nonce, v->noncelen, v->header, v->headerlen, ct, sizeof(ct), tag, 0, out) != -1)
+        {
+            printf("decrypt verify mt empty tag\n");
+            exit(-1);
+        }
+
+        for (int i = 0; i < sizeof(out); i++)
+        {
+            if (out[i])
+            {
+                printf("decrypt verify mt leaked\n");
+                exit(-1);
+            }
+        }
+    }
+}
+#endif
+
+static void run_tests(void)
+{
+#if USE_AES_BLOCKS
+    test_aes_blocks();
+#endif
+
+#if USE_CUSTOM_MATH128
+    test_math128();
+#endif
+
     test_ctr_ovf();
+    test_ctr_64(&testvectors[5]);
 
     for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
         test_vector(&testvectors[i]);
 
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_buf(&testvectors[i]);
+
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_encrypt(&testvectors[i]);
+
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_verify(&testvectors[i]);
+
+    for (int i = 0; i + 1 < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_pair(&testvectors[i], &testvectors[i + 1]);
+
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_compact(&testvectors[i]);
+
+    test_reset();
+
+    test_verify_batch();
+
+#if USE_MT
+    test_crypt_mt();
+    test_decrypt_verify_mt();
+#endif
+}
+
+int main(void)
+{
+#if USE_AESNI || USE_AESVAES
+    if (!aes128ni_supported())
+    {
+        printf("No AES-NI, skipped");
+        return 0;
+    }
+#endif
+
+#if USE_AESVAES
+    have_vaes = aes128vaes_supported();
+    if (!have_vaes)
+        printf("No VAES, AES-NI fallback. ");
+#endif
+
+#if USE_DISPATCH
+    eax128_aes_init();
+    printf("%s: ", eax128_aes_backend_name());
+
+    for (int b = 0; b < EAX128_AES_NBACKENDS; b++)
+    {
+        if (eax128_aes_force(b) == 0)
+        {
+            if (eax128_aes_backend() != b)
+            {
+                printf("force failed\n");
+                exit(-1);
+            }
+            run_tests();
+        }
+    }
+#else
+    run_tests();
+#endif
+
     printf("Ok");
     return 0;
 }
@@ -0,0 +1,163 @@
+#define _POSIX_C_SOURCE 200112L
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "eax128.h"
+#include "eax128_aes.h"
+#include "aes128.h"
+
+// the per-stream context footprint benchmark. the n contexts (1M by default) are visited in a scattered order,
+// each visit encrypts the next 16 bytes of its stream. the eax128_t and the compact eax128c_t do the same work,
+// so the difference is the memory traffic of the contexts.
+// there are no portable miss counters, so the time is the proxy. the cache lines spanned per visit are printed too:
+// the contexts are 64-byte aligned arrays, and each of the lines is a miss once the set outgrows the cache.
+// usage: eax_ctx_bench.exe [ncontexts] [rounds]
+
+// the singleton store of aes128.c is not used, but has to be linked
+static uint32_t aes_regs[AES128_NREGS];
+
+void aes128_streg(int i, uint32_t w)
+{
+    aes_regs[i] = w;
+}
+
+uint32_t aes128_ldreg(int i)
+{
+    return aes_regs[i];
+}
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// the average number of the 64-byte lines spanned by an element of the aligned array
+static double lines_per_elem(size_t size)
+{
+    size_t lines = 0;
+
+    // the layout repeats every 64 elements
+    for (size_t j = 0; j < 64; j++)
+        lines += (j * size + size - 1) / 64 - (j * size) / 64 + 1;
+
+    return lines / 64.0;
+}
+
+// full-period lcg mod 2^k, so every context is visited once per round
+static uint32_t next_idx(uint32_t i, uint32_t mask)
+{
+    return (i * 1664525u + 1013904223u) & mask;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int bits = 20;
+    unsigned int rounds = 4;
+
+    if (argc > 1)
+    {
+        unsigned long n = strtoul(argv[1], NULL, 0);
+        bits = 0;
+        while ((1UL << bits) < n)
+            bits++;
+    }
+    if (argc > 2)
+        rounds = strtoul(argv[2], NULL, 0);
+
+    uint32_t n = 1u << bits;
+    uint32_t mask = n - 1;
+    static const uint8_t header[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t key[16] = {0};
+    uint8_t data[16] = {0};
+    uint8_t out[16];
+    uint8_t tag[16];
+    uint8_t sum = 0;
+    eax128_aes_ctx_t aes;
+    eax128_key_t eax_key;
+
+    eax128_aes_init();
+    eax128_aes_set_key(&aes, key);
+    eax128_key_init(&eax_key, &aes);
+
+    void *full_mem = NULL;
+    void *compact_mem = NULL;
+    if (posix_memalign(&full_mem, 64, sizeof(eax128_t) * n) || posix_memalign(&compact_mem, 64, sizeof(eax128c_t) * n))
+    {
+        printf("no memory\n");
+        return -1;
+    }
+    eax128_t *full = full_mem;
+    eax128c_t *compact = compact_mem;
+
+    printf("aes: %s, %u contexts, %u rounds\n", eax128_aes_backend_name(), n, rounds);
+    printf("eax128_t:  %3d bytes, %6.1f MB, %.2f cache lines per visit\n",
+           (int)sizeof(eax128_t), sizeof(eax128_t) * (double)n / 1e6, lines_per_elem(sizeof(eax128_t)));
+    printf("eax128c_t: %3d bytes, %6.1f MB, %.2f cache lines per visit\n",
+           (int)sizeof(eax128c_t), sizeof(eax128c_t) * (double)n / 1e6, lines_per_elem(sizeof(eax128c_t)));
+
+    double t = now();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        eax128_init(&full[i], &eax_key, (const uint8_t *)&i, sizeof(i));
+        eax128_auth_header_buf(&full[i], header, sizeof(header));
+    }
+    double t_init_full = now() - t;
+
+    t = now();
+    for (uint32_t i = 0; i < n; i++)
+        eax128c_init(&compact[i], &eax_key, (const uint8_t *)&i, sizeof(i), header, sizeof(header));
+    double t_init_compact = now() - t;
+
+    t = now();
+    for (unsigned int r = 0; r < rounds; r++)
+    {
+        uint32_t idx = r;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            idx = next_idx(idx, mask);
+            eax128_encrypt_update(&full[idx], data, out, sizeof(data));
+        }
+    }
+    double t_full = now() - t;
+
+    t = now();
+    for (unsigned int r = 0; r < rounds; r++)
+    {
+        uint32_t idx = r;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            idx = next_idx(idx, mask);
+            eax128c_encrypt_update(&compact[idx], data, out, sizeof(data));
+        }
+    }
+    double t_compact = now() - t;
+
+    // the streams should agree
+    uint32_t step = n >= 16 ? n / 16 : 1;
+    for (uint32_t i = 0; i < n; i += step)
+    {
+        uint8_t tag_c[16];
+        eax128_digest(&full[i], tag);
+        eax128c_digest(&compact[i], tag_c);
+        if (memcmp(tag, tag_c, 16) != 0)
+        {
+            printf("tag mismatch %u\n", i);
+            return -1;
+        }
+        sum ^= tag[0];
+    }
+
+    double visits = (double)n * rounds;
+    printf("init+header: eax128_t %.1f ns, eax128c_t %.1f ns per message\n", t_init_full * 1e9 / n, t_init_compact * 1e9 / n);
+    printf("16-byte update: eax128_t %.1f ns, eax128c_t %.1f ns per visit (%02x)\n",
+           t_full * 1e9 / visits, t_compact * 1e9 / visits, sum);
+
+    free(full_mem);
+    free(compact_mem);
+    return 0;
+}
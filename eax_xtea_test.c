@@ -5,50 +5,35 @@
 
 #include "eax64.h"
 
+// build with USE_SPECK=1 (and speck64.c, eax64_speck.c instead of the xtea ones) to run all the tests on the Speck64/128
+#ifndef USE_SPECK
+#define USE_SPECK 0
+#endif
+
+#if USE_SPECK
+#include "speck64.h"
+#include "vectors_eax_speck.h"
+typedef speck64_key_t cipher_key_t;
+#define cipher_set_key          speck64_set_key
+#define cipher_encrypt          speck64_encrypt
+#else
+#include "xtea.h"
 #include "vectors_eax_xtea.h"
+typedef xtea_key_t cipher_key_t;
+#define cipher_set_key          xtea_set_key
+#define cipher_encrypt          xtea_encrypt
+#endif
 
-static struct
-{
-    uint32_t key[4];
-} xtea_rt;
+// the cipher is bound to eax64 by eax64_xtea.c or eax64_speck.c, the cipher ctx is the cipher_key
+static cipher_key_t cipher_key;
+static eax64_key_t eax_key;
 
-void xtea_install_key(const uint8_t *key)
+void cipher_install_key(const uint8_t *key)
 {
-    memcpy(xtea_rt.key, key, 16);
+    cipher_set_key(&cipher_key, key);
+    eax64_key_init(&eax_key, &cipher_key);
 }
 
-
-uint64_t xtea_ecb(uint64_t block)
-{
-   uint32_t sum = 0;
-   uint32_t delta = 0x9E3779B9;
-
-   uint32_t v0 = block;
-   uint32_t v1 = block >> 32;
-
-   for (int i = 0; i < 32; i++)
-   {
-       uint32_t r;
-
-       r = ((v1<<4) ^ (v1>>5)) + v1;
-       r ^= sum + xtea_rt.key[sum & 3];
-       v0 += r;
-
-       sum += delta;
-
-       r = ((v0<<4) ^ (v0>>5)) + v0;
-       r ^= sum + xtea_rt.key[(sum >> 11) & 3];
-       v1 += r;
-   }
-
-   return ((uint64_t)v1 << 32) | v0;
-}
-
-
-extern void xtea_install_key(const uint8_t *key);
-extern uint64_t xtea_ecb(uint64_t block);
-extern void xtea_clear(void);
-
 void print64(uint64_t q)
 {
     printf("%08x%08x", (uint32_t)(q >> 32), (uint32_t)q);
@@ -71,18 +56,13 @@ void print_dump(const void *data, int len)
     printf("\n");
 }
 
-uint64_t eax64_cipher(void *ctx, uint64_t pt)
-{
-    return xtea_ecb(pt);
-}
-
 static void test_vector(const testvector_t *v)
 {
     eax64_t ctx;
 
-    xtea_install_key(v->key);
+    cipher_install_key(v->key);
 
-    eax64_init(&ctx, NULL, v->nonce, v->noncelen);
+    eax64_init(&ctx, &eax_key, v->nonce, v->noncelen);
 
     uint8_t pt[256];
 
@@ -117,12 +97,329 @@ static void test_vector(const testvector_t *v)
 }
 
 
+static void test_vector_buf(const testvector_t *v)
+{
+    eax64_t ctx;
+
+    cipher_install_key(v->key);
+
+    eax64_init(&ctx, &eax_key, v->nonce, v->noncelen);
+
+    uint8_t pt[256];
+
+    // split at some odd point to get the unaligned heads and tails
+    int hsplit = v->headerlen / 3;
+    int csplit = v->ctlen / 3;
+
+    for (int i = 0; i < hsplit; i++)
+        eax64_auth_header(&ctx, v->header[i]);
+    eax64_auth_header_buf(&ctx, &v->header[hsplit], v->headerlen - hsplit);
+
+    eax64_auth_data_buf(&ctx, v->ct, csplit);
+    for (int i = csplit; i < v->ctlen; i++)
+        eax64_auth_data(&ctx, v->ct[i]);
+
+    memcpy(pt, v->ct, v->ctlen);
+    eax64_crypt_buf(&ctx, 0, pt, pt, csplit);
+    eax64_crypt_buf(&ctx, csplit, &pt[csplit], &pt[csplit], v->ctlen - csplit);
+
+    uint64_t tag = eax64_digest(&ctx);
+
+    if (memcmp(pt, v->pt, v->ptlen) != 0)
+    {
+        print_dump(pt, v->ptlen);
+        print_dump(v->pt, v->ptlen);
+        printf("buf decrypt fail\n");
+        exit(-1);
+    }
+
+    if (memcmp(&tag, v->tag, v->taglen) != 0)
+    {
+        print_dump(v->tag, v->taglen);
+        print_dump(&tag, 8);
+        printf("buf auth fail\n");
+        exit(-1);
+    }
+}
+
+static void test_vector_encrypt(const testvector_t *v)
+{
+    eax64_t ctx;
+
+    cipher_install_key(v->key);
+
+    eax64_init(&ctx, &eax_key, v->nonce, v->noncelen);
+    eax64_auth_header_buf(&ctx, v->header, v->headerlen);
+
+    uint8_t ct[256];
+
+    // odd-sized pieces to exercise the unaligned paths
+    int pos = 0;
+    int piece = 1;
+    while (pos < v->ptlen)
+    {
+        int n = v->ptlen - pos < piece ? v->ptlen - pos : piece;
+        eax64_encrypt_update(&ctx, &v->pt[pos], &ct[pos], n);
+        pos += n;
+        piece += 7;
+    }
+
+    uint64_t tag = eax64_digest(&ctx);
+
+    if (memcmp(ct, v->ct, v->ctlen) != 0)
+    {
+        print_dump(ct, v->ctlen);
+        print_dump(v->ct, v->ctlen);
+        printf("encrypt fail\n");
+        exit(-1);
+    }
+
+    if (memcmp(&tag, v->tag, v->taglen) != 0)
+    {
+        print_dump(v->tag, v->taglen);
+        print_dump(&tag, 8);
+        printf("encrypt auth fail\n");
+        exit(-1);
+    }
+}
+
+static void test_vector_verify(const testvector_t *v)
+{
+    uint8_t pt[256];
+    uint8_t tag[16];
+
+    cipher_install_key(v->key);
+
+    memset(pt, 0xAA, sizeof(pt));
+    if (eax64_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                             v->ct, v->ctlen, v->tag, v->taglen, pt) != 0)
+    {
+        printf("verify fail\n");
+        exit(-1);
+    }
+
+    if (memcmp(pt, v->pt, v->ptlen) != 0)
+    {
+        print_dump(pt, v->ptlen);
+        print_dump(v->pt, v->ptlen);
+        printf("verify decrypt fail\n");
+        exit(-1);
+    }
+
+    // empty or negative-length tag should be rejected
+    memset(pt, 0xAA, sizeof(pt));
+    if (eax64_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                             v->ct, v->ctlen, v->tag, 0, pt) == 0
+        || eax64_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                                v->ct, v->ctlen, v->tag, -1, pt) == 0
+        || pt[0] != 0xAA)
+    {
+        printf("verify empty tag fail\n");
+        exit(-1);
+    }
+
+    // broken tag should be rejected and plaintext left untouched
+    memcpy(tag, v->tag, v->taglen);
+    tag[v->taglen - 1] ^= 1;
+    memset(pt, 0xAA, sizeof(pt));
+    if (eax64_decrypt_verify(&eax_key, v->nonce, v->noncelen, v->header, v->headerlen,
+                             v->ct, v->ctlen, tag, v->taglen, pt) == 0)
+    {
+        printf("verify broken tag fail\n");
+        exit(-1);
+    }
+
+    for (int i = 0; i < v->ctlen; i++)
+    {
+        if (pt[i] != 0xAA)
+        {
+            printf("verify leaked plaintext\n");
+            exit(-1);
+        }
+    }
+}
+
+// the stream positions are 64-bit: the keystream past 2^32 blocks must be E(N + blocknum)
+static void test_ctr_64(const testvector_t *v)
+{
+    static const uint64_t firsts[] = {(1ULL << 32) - 2, (1ULL << 35) + 5, (1ULL << 61) - 4};
+    eax64_t ctx;
+
+    cipher_install_key(v->key);
+    eax64_init(&ctx, &eax_key, v->nonce, v->noncelen);
+
+    for (int f = 0; f < sizeof(firsts) / sizeof(firsts[0]); f++)
+    {
+        for (int b = 0; b < 4; b++)
+        {
+            uint64_t blocknum = firsts[f] + b;
+            eax64_block_t ks;
+
+            ks.q = cipher_encrypt(&cipher_key, ctx.ctr.nonce + blocknum);
+
+            for (int i = 0; i < 8; i++)
+            {
+                if (eax64_crypt_data(&ctx, blocknum * 8 + i, 0) != ks.b[i])
+                {
+                    printf("ctr 64 failed\n");
+                    exit(-1);
+                }
+            }
+        }
+    }
+
+    eax64_clear(&ctx);
+}
+
+// the multi-block hook (portable, 2-way or vector, whatever is linked) should match the single block cipher
+static void test_blocks(void)
+{
+    uint64_t blocks[20];
+    uint64_t expected[20];
+
+    cipher_install_key(testvectors[1].key);
+
+    for (unsigned int n = 0; n <= 20; n++)
+    {
+        for (int i = 0; i < 20; i++)
+            blocks[i] = expected[i] = 0x0123456789ABCDEFULL * (i + 1) + n;
+
+        for (unsigned int i = 0; i < n; i++)
+            expected[i] = cipher_encrypt(&cipher_key, expected[i]);
+        eax64_cipher_blocks(&cipher_key, blocks, n);
+
+        if (memcmp(blocks, expected, sizeof(blocks)) != 0)
+        {
+            printf("blocks fail\n");
+            exit(-1);
+        }
+    }
+}
+
+// a context reset for the each next message should match the freshly inited ones, even if the previous message is dropped midway
+static void test_reset(void)
+{
+    eax64_t ctx;
+
+    cipher_install_key(testvectors[0].key);
+    eax64_init(&ctx, &eax_key, testvectors[0].nonce, testvectors[0].noncelen);
+
+    for (int i = 0; i < 20; i++)
+    {
+        const testvector_t *v = &testvectors[i];
+        uint8_t ct[256], ref_ct[256];
+        uint64_t tag, ref_tag;
+        eax64_t ref;
+
+        eax64_init(&ref, &eax_key, v->nonce, v->noncelen);
+        eax64_auth_header_buf(&ref, v->header, v->headerlen);
+        eax64_encrypt_update(&ref, v->pt, ref_ct, v->ptlen);
+        ref_tag = eax64_digest(&ref);
+
+        // start a message and drop it
+        if (i % 4 == 3)
+        {
+            eax64_reset(&ctx, v->header, v->headerlen);
+            eax64_auth_header_buf(&ctx, v->pt, v->ptlen);
+            eax64_encrypt_update(&ctx, v->header, ct, v->headerlen);
+        }
+
+        eax64_reset(&ctx, v->nonce, v->noncelen);
+        eax64_auth_header_buf(&ctx, v->header, v->headerlen);
+        eax64_encrypt_update(&ctx, v->pt, ct, v->ptlen);
+        tag = eax64_digest(&ctx);
+
+        if (memcmp(ct, ref_ct, v->ptlen) != 0 || tag != ref_tag)
+        {
+            printf("reset fail %d\n", i);
+            exit(-1);
+        }
+    }
+
+    eax64_clear(&ctx);
+}
+
+static void test_verify_batch(void)
+{
+    enum { NMSGS = 37 };
+    static eax64_msg_t msgs[NMSGS];
+    static uint8_t ct[NMSGS][256];
+    static uint64_t tags[NMSGS];
+    const int nvectors = sizeof(testvectors) / sizeof(testvectors[0]);
+    uint8_t ok[(NMSGS + 7) / 8];
+
+    cipher_install_key(testvectors[0].key);
+
+    // the vectors differ in key, so the messages are the vectors data under the same key
+    for (int i = 0; i < NMSGS; i++)
+    {
+        const testvector_t *v = &testvectors[i % nvectors];
+        int len = (v->ptlen + i) % (v->ptlen + 1);
+        eax64_t ctx;
+
+        eax64_init(&ctx, &eax_key, v->nonce, v->noncelen);
+        eax64_auth_header_buf(&ctx, v->header, (v->headerlen + i) % (v->headerlen + 1));
+        eax64_encrypt_update(&ctx, v->pt, ct[i], len);
+        tags[i] = eax64_digest(&ctx);
+
+        // every third is broken, either the ciphertext or tag
+        if (i % 3 == 1)
+        {
+            if (len && i % 2)
+                ct[i][len - 1] ^= 0x10;
+            else
+                tags[i] ^= 1ULL << (i % 64);
+        }
+
+        msgs[i] = (eax64_msg_t){v->nonce, v->noncelen, v->header, (v->headerlen + i) % (v->headerlen + 1),
+                                ct[i], len, (const uint8_t *)&tags[i], 8};
+    }
+
+    eax64_verify_batch(&eax_key, msgs, NMSGS, ok);
+
+    for (int i = 0; i < NMSGS; i++)
+    {
+        if (((ok[i / 8] >> (i % 8)) & 1) != (i % 3 != 1))
+        {
+            printf("batch fail %d\n", i);
+            exit(-1);
+        }
+    }
+
+    // the empty tag is never authentic
+    msgs[0].tag_len = 0;
+    eax64_verify_batch(&eax_key, msgs, 1, ok);
+    if (ok[0] & 1)
+    {
+        printf("batch empty tag fail\n");
+        exit(-1);
+    }
+}
+
+
 int main(void)
 {
 
     for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
         test_vector(&testvectors[i]);
 
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_buf(&testvectors[i]);
+
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_encrypt(&testvectors[i]);
+
+    for (int i = 0; i < sizeof(testvectors) / sizeof(testvectors[0]); i++)
+        test_vector_verify(&testvectors[i]);
+
+    test_ctr_64(&testvectors[1]);
+
+    test_blocks();
+
+    test_reset();
+
+    test_verify_batch();
+
     printf("Ok");
     return 0;
 }
@@ -0,0 +1,209 @@
+#include <stdint.h>
+#include <string.h>
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include "math128x86.h"
+
+#define SSSE3   __attribute__((target("ssse3")))
+#define MOVBE   __attribute__((target("movbe")))
+#define SSE2    __attribute__((target("sse2")))
+
+#ifndef MATH128X86_HOOKS
+#define MATH128X86_HOOKS 0      // 1: define the eax128 hooks with the ssse3 set, 2: with the movbe set
+#endif
+
+int math128x86_ssse3_supported(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (ecx & bit_SSSE3) != 0;
+}
+
+int math128x86_movbe_supported(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (ecx & bit_MOVBE) != 0;
+}
+
+
+// ssse3
+
+SSSE3 static inline __m128i bswap128(__m128i v)
+{
+    return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// the qwords go via memory: the _mm_cvtsi128_si64 is x86-64 only
+SSSE3 static inline __m128i add128(__m128i v, uint64_t inc)
+{
+    uint64_t q[2];
+
+    _mm_storeu_si128((__m128i *)q, v);
+    q[0] += inc;
+    q[1] += q[0] < inc;
+
+    return _mm_loadu_si128((const __m128i *)q);
+}
+
+// x * 2^n in GF(2^128), v is little-endian
+SSSE3 static inline __m128i gf_double(__m128i v, int n)
+{
+    const __m128i poly = _mm_set_epi64x(1, 0x87);
+
+    do
+    {
+        // the top bits of the qwords, swapped: the low one moves into the high qword, the high one is reduced
+        __m128i c = _mm_shuffle_epi32(_mm_srli_epi64(v, 63), 0x4E);
+
+        v = _mm_slli_epi64(v, 1);
+        v = _mm_xor_si128(v, _mm_and_si128(_mm_sub_epi64(_mm_setzero_si128(), c), poly));
+    } while (--n);
+
+    return v;
+}
+
+SSSE3 void math128x86_add128be_64le_ssse3(uint32_t dst[4], const uint32_t a[4], uint64_t inc)
+{
+    __m128i v = bswap128(_mm_loadu_si128((const __m128i *)a));
+    _mm_storeu_si128((__m128i *)dst, bswap128(add128(v, inc)));
+}
+
+SSSE3 void math128x86_add128le_64le_ssse3(uint32_t dst[4], const uint32_t a[4], uint64_t inc)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)a);
+    _mm_storeu_si128((__m128i *)dst, add128(v, inc));
+}
+
+SSSE3 void math128x86_gf_double_128be_ssse3(uint32_t dst[4], const uint32_t src[4], int n)
+{
+    __m128i v = bswap128(_mm_loadu_si128((const __m128i *)src));
+    _mm_storeu_si128((__m128i *)dst, bswap128(gf_double(v, n)));
+}
+
+SSSE3 void math128x86_gf_double_128le_ssse3(uint32_t dst[4], const uint32_t src[4], int n)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)src);
+    _mm_storeu_si128((__m128i *)dst, gf_double(v, n));
+}
+
+
+// movbe. the plain scalar 64-bit code, the words are accessed via memcpy to stay alias-safe,
+// the big-endian loads and stores compile to movbe
+
+MOVBE static inline uint64_t ld64(const uint32_t *p, int be)
+{
+    uint64_t q;
+    memcpy(&q, p, 8);
+    return be ? __builtin_bswap64(q) : q;
+}
+
+MOVBE static inline void st64(uint32_t *p, uint64_t q, int be)
+{
+    q = be ? __builtin_bswap64(q) : q;
+    memcpy(p, &q, 8);
+}
+
+MOVBE static inline void add128_q(uint32_t dst[4], const uint32_t a[4], uint64_t inc, int be)
+{
+    uint64_t lo = ld64(be ? &a[2] : &a[0], be);
+    uint64_t hi = ld64(be ? &a[0] : &a[2], be);
+
+    hi += __builtin_add_overflow(lo, inc, &lo);
+
+    st64(be ? &dst[2] : &dst[0], lo, be);
+    st64(be ? &dst[0] : &dst[2], hi, be);
+}
+
+MOVBE static inline void gf_double_q(uint32_t dst[4], const uint32_t src[4], int n, int be)
+{
+    uint64_t lo = ld64(be ? &src[2] : &src[0], be);
+    uint64_t hi = ld64(be ? &src[0] : &src[2], be);
+
+    do
+    {
+        uint64_t m = (0 - (hi >> 63)) & 0x87;
+        hi = (hi << 1) | (lo >> 63);
+        lo = (lo << 1) ^ m;
+    } while (--n);
+
+    st64(be ? &dst[2] : &dst[0], lo, be);
+    st64(be ? &dst[0] : &dst[2], hi, be);
+}
+
+MOVBE void math128x86_add128be_64le_movbe(uint32_t dst[4], const uint32_t a[4], uint64_t inc)
+{
+    add128_q(dst, a, inc, 1);
+}
+
+MOVBE void math128x86_add128le_64le_movbe(uint32_t dst[4], const uint32_t a[4], uint64_t inc)
+{
+    add128_q(dst, a, inc, 0);
+}
+
+MOVBE void math128x86_gf_double_128be_movbe(uint32_t dst[4], const uint32_t src[4], int n)
+{
+    gf_double_q(dst, src, n, 1);
+}
+
+MOVBE void math128x86_gf_double_128le_movbe(uint32_t dst[4], const uint32_t src[4], int n)
+{
+    gf_double_q(dst, src, n, 0);
+}
+
+
+// sse2 is the x86-64 baseline, and any 32-bit cpu with ssse3 or movbe has it too
+
+SSE2 void math128x86_xor128_sse2(uint32_t dst[4], const uint32_t a[4], const uint32_t b[4])
+{
+    __m128i va = _mm_loadu_si128((const __m128i *)a);
+    __m128i vb = _mm_loadu_si128((const __m128i *)b);
+    _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(va, vb));
+}
+
+
+#if MATH128X86_HOOKS
+void _add128be_64le(uint32_t dst[4], const uint32_t a[4], uint64_t inc)
+{
+    if (MATH128X86_HOOKS == 2)
+        math128x86_add128be_64le_movbe(dst, a, inc);
+    else
+        math128x86_add128be_64le_ssse3(dst, a, inc);
+}
+
+void _add128le_64le(uint32_t dst[4], const uint32_t a[4], uint64_t inc)
+{
+    if (MATH128X86_HOOKS == 2)
+        math128x86_add128le_64le_movbe(dst, a, inc);
+    else
+        math128x86_add128le_64le_ssse3(dst, a, inc);
+}
+
+void _gf_double_128be(uint32_t dst[4], const uint32_t src[4], int n)
+{
+    if (MATH128X86_HOOKS == 2)
+        math128x86_gf_double_128be_movbe(dst, src, n);
+    else
+        math128x86_gf_double_128be_ssse3(dst, src, n);
+}
+
+void _gf_double_128le(uint32_t dst[4], const uint32_t src[4], int n)
+{
+    if (MATH128X86_HOOKS == 2)
+        math128x86_gf_double_128le_movbe(dst, src, n);
+    else
+        math128x86_gf_double_128le_ssse3(dst, src, n);
+}
+
+void _xor128(uint32_t dst[4], const uint32_t a[4], const uint32_t b[4])
+{
+    math128x86_xor128_sse2(dst, a, b);
+}
+#endif
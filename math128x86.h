@@ -0,0 +1,33 @@
+#ifndef _MATH128X86_H_
+#define _MATH128X86_H_
+
+/*
+    x86-64 implementations of the eax128 USE_CUSTOM_MATH128 hooks.
+
+    ssse3: the block is byte-swapped with one PSHUFB, the xor and the doubling are 128-bit SSE2 ops.
+    movbe: the counter and the doubling are the plain scalar 64-bit ops, the big-endian words are loaded
+           and stored with MOVBE, the xor is SSE2.
+
+    Build this file with MATH128X86_HOOKS=1 (ssse3) or 2 (movbe) (and eax128.c with USE_CUSTOM_MATH128=1),
+    it then defines the hooks itself. No CPU check then, the CPU must have the extension.
+    The hooks are the out-of-line calls, the eax128_aes dispatch keeps the built-in inline math and dispatches only the cipher.
+
+    The code is compiled with the target attributes, so no special compiler flags are required.
+*/
+
+int math128x86_ssse3_supported(void);
+int math128x86_movbe_supported(void);
+
+void math128x86_add128be_64le_ssse3(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+void math128x86_add128le_64le_ssse3(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+void math128x86_gf_double_128be_ssse3(uint32_t dst[4], const uint32_t src[4], int n);
+void math128x86_gf_double_128le_ssse3(uint32_t dst[4], const uint32_t src[4], int n);
+
+void math128x86_add128be_64le_movbe(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+void math128x86_add128le_64le_movbe(uint32_t dst[4], const uint32_t a[4], uint64_t inc);
+void math128x86_gf_double_128be_movbe(uint32_t dst[4], const uint32_t src[4], int n);
+void math128x86_gf_double_128le_movbe(uint32_t dst[4], const uint32_t src[4], int n);
+
+void math128x86_xor128_sse2(uint32_t dst[4], const uint32_t a[4], const uint32_t b[4]);
+
+#endif
@@ -0,0 +1,35 @@
+MASK32 = (1 << 32) - 1
+
+def ror(x, r):
+    return ((x >> r) | (x << (32 - r))) & MASK32
+
+def rol(x, r):
+    return ((x << r) | (x >> (32 - r))) & MASK32
+
+# Speck64/128: 32-bit words, 27 rounds.
+# the words are little-endian like in the implementation guide: the key bytes are k0, l0, l1, l2,
+# the block bytes are y, x
+class Speck64:
+    def __init__(self, key, rounds=27):
+        if len(key) != 16:
+            raise Exception('Expecting the 128 bit (16 bytes) key')
+
+        key = int.from_bytes(key, 'little', signed=False)
+        k = key & MASK32
+        l = [(key >> 32) & MASK32, (key >> 64) & MASK32, (key >> 96) & MASK32]
+
+        schkey = []
+        for i in range(rounds):
+            schkey.append(k)
+            l.append(((k + ror(l[i], 8)) & MASK32) ^ i)
+            k = rol(k, 3) ^ l[i + 3]
+        self.schkey = schkey
+
+    def encrypt(self, pt):
+        pt = int.from_bytes(pt, 'little', signed=False)
+        y, x = (pt >> 0) & MASK32, (pt >> 32) & MASK32
+        for k in self.schkey:
+            x = ((ror(x, 8) + y) & MASK32) ^ k
+            y = rol(y, 3) ^ x
+        ct = (x << 32) | y
+        return ct.to_bytes(8, 'little')
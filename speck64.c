@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <string.h>
+#include "speck64.h"
+
+static inline uint32_t u8to32le(const uint8_t *b)
+{
+    return (b[0] << 0) | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static inline uint32_t ror32(uint32_t x, int r)
+{
+    return (x >> r) | (x << (32 - r));
+}
+
+static inline uint32_t rol32(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+void speck64_set_key(speck64_key_t *ctx, const uint8_t key[16])
+{
+    uint32_t k = u8to32le(&key[0]);
+    uint32_t l[3];
+
+    for (int i = 0; i < 3; i++)
+        l[i] = u8to32le(&key[4 + i * 4]);
+
+    // the l words are used once, so the ring of 3 is enough
+    for (int i = 0; i < 27; i++)
+    {
+        ctx->rk[i] = k;
+        uint32_t li = (k + ror32(l[i % 3], 8)) ^ i;
+        l[i % 3] = li;
+        k = rol32(k, 3) ^ li;
+    }
+
+    k = 0;
+    memset(l, 0, sizeof(l));
+}
+
+uint64_t speck64_encrypt(const speck64_key_t *ctx, uint64_t block)
+{
+    uint32_t y = block;
+    uint32_t x = block >> 32;
+
+    for (int i = 0; i < 27; i++)
+    {
+        x = (ror32(x, 8) + y) ^ ctx->rk[i];
+        y = rol32(y, 3) ^ x;
+    }
+
+    return ((uint64_t)x << 32) | y;
+}
+
+// two blocks per round, the chains are independent so they overlap in the pipeline
+void speck64_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    while (n >= 2)
+    {
+        uint32_t ay = blocks[0];
+        uint32_t ax = blocks[0] >> 32;
+        uint32_t by = blocks[1];
+        uint32_t bx = blocks[1] >> 32;
+
+        for (int i = 0; i < 27; i++)
+        {
+            ax = (ror32(ax, 8) + ay) ^ ctx->rk[i];
+            bx = (ror32(bx, 8) + by) ^ ctx->rk[i];
+            ay = rol32(ay, 3) ^ ax;
+            by = rol32(by, 3) ^ bx;
+        }
+
+        blocks[0] = ((uint64_t)ax << 32) | ay;
+        blocks[1] = ((uint64_t)bx << 32) | by;
+
+        blocks += 2;
+        n -= 2;
+    }
+
+    if (n)
+        blocks[0] = speck64_encrypt(ctx, blocks[0]);
+}
+
+void speck64_clear(speck64_key_t *ctx)
+{
+    memset(ctx, 0, sizeof(speck64_key_t));
+}
@@ -0,0 +1,33 @@
+#ifndef _SPECK64_H_
+#define _SPECK64_H_
+
+/*
+    Speck64/128: 27 rounds, 64-bit block, 128-bit key (Beaulieu et al., "The SIMON and SPECK families of lightweight block ciphers").
+
+    The round is a rotate, add, xor, rotate and xor on the 32-bit words, so it's a way shorter than the XTEA one.
+    The round keys are expanded once by the speck64_set_key (see speck.py).
+
+    The byte order is the one of the implementation guide: the key bytes are the little-endian words k0, l0, l1, l2,
+    the block is the little-endian uint64_t of the 8 bytes, the low word is y, the high one is x.
+
+    The flow is:
+     1) speck64_set_key(ctx, key)
+     2) speck64_encrypt(ctx, block) or speck64_encrypt_blocks(ctx, blocks, n)
+     3) speck64_clear(ctx)
+
+    The context is read-only while encrypting, so the single context may be shared by threads.
+    eax64_speck.c binds it to the eax64 (the cipher_ctx is the speck64_key_t).
+    speck64vec.c/h is the SSE2/AVX2 version of the speck64_encrypt_blocks.
+*/
+
+typedef struct
+{
+    uint32_t rk[27];
+} speck64_key_t;
+
+void speck64_set_key(speck64_key_t *ctx, const uint8_t key[16]);
+uint64_t speck64_encrypt(const speck64_key_t *ctx, uint64_t block);
+void speck64_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n);
+void speck64_clear(speck64_key_t *ctx);
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "speck64vec.h"
+#include "cpux86.h"
+
+#define SSE2    __attribute__((target("sse2")))
+#define AVX2    __attribute__((target("avx2")))
+
+int speck64vec_avx2_supported(void)
+{
+    return cpux86_avx2_supported();
+}
+
+// the (y x) word pairs are gathered into the y and x registers like in xteavec.c
+
+#define ROR128(v, r)    _mm_or_si128(_mm_srli_epi32(v, r), _mm_slli_epi32(v, 32 - (r)))
+#define ROL128(v, r)    _mm_or_si128(_mm_slli_epi32(v, r), _mm_srli_epi32(v, 32 - (r)))
+
+SSE2 void speck64vec_sse2_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    __m128i *p = (__m128i *)blocks;
+
+    while (n >= 4)
+    {
+        __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(p + 0), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(p + 1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i y = _mm_unpacklo_epi64(a, b);
+        __m128i x = _mm_unpackhi_epi64(a, b);
+
+        for (int i = 0; i < 27; i++)
+        {
+            x = _mm_xor_si128(_mm_add_epi32(ROR128(x, 8), y), _mm_set1_epi32(ctx->rk[i]));
+            y = _mm_xor_si128(ROL128(y, 3), x);
+        }
+
+        a = _mm_unpacklo_epi64(y, x);
+        b = _mm_unpackhi_epi64(y, x);
+        _mm_storeu_si128(p + 0, _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm_storeu_si128(p + 1, _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        p += 2;
+        n -= 4;
+    }
+
+    if (n)
+        speck64_encrypt_blocks(ctx, (uint64_t *)p, n);
+}
+
+#define ROL256(v, r)    _mm256_or_si256(_mm256_slli_epi32(v, r), _mm256_srli_epi32(v, 32 - (r)))
+
+AVX2 void speck64vec_avx2_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    __m256i *p = (__m256i *)blocks;
+
+    // ror 8 of each word is the byte rotate
+    const __m256i ror8 = _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                          1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+
+    while (n >= 8)
+    {
+        __m256i a = _mm256_shuffle_epi32(_mm256_loadu_si256(p + 0), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i b = _mm256_shuffle_epi32(_mm256_loadu_si256(p + 1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i y = _mm256_unpacklo_epi64(a, b);
+        __m256i x = _mm256_unpackhi_epi64(a, b);
+
+        for (int i = 0; i < 27; i++)
+        {
+            x = _mm256_xor_si256(_mm256_add_epi32(_mm256_shuffle_epi8(x, ror8), y), _mm256_set1_epi32(ctx->rk[i]));
+            y = _mm256_xor_si256(ROL256(y, 3), x);
+        }
+
+        a = _mm256_unpacklo_epi64(y, x);
+        b = _mm256_unpackhi_epi64(y, x);
+        _mm256_storeu_si256(p + 0, _mm256_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256(p + 1, _mm256_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        p += 2;
+        n -= 8;
+    }
+
+    if (n)
+        speck64vec_sse2_encrypt_blocks(ctx, (uint64_t *)p, n);
+}
+
+void speck64vec_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    if (cpux86_avx2_supported())
+        speck64vec_avx2_encrypt_blocks(ctx, blocks, n);
+    else
+        speck64vec_sse2_encrypt_blocks(ctx, blocks, n);
+}
@@ -0,0 +1,30 @@
+#ifndef _SPECK64VEC_H_
+#define _SPECK64VEC_H_
+
+#include "speck64.h"
+
+/*
+    Speck64/128 on the SSE2 and AVX2 registers.
+
+    Same layout as xteavec.c: a register of y words and a register of x words hold 4 blocks (SSE2) or 8 blocks (AVX2).
+    The AVX2 code rotates x by 8 with the byte shuffle, the rest of rotates are the shift pairs.
+
+    The flow is:
+     1) speck64_set_key(ctx, key)
+     2) speck64vec_encrypt_blocks(ctx, blocks, n). It takes the AVX2 code if the cpu and OS support it, SSE2 otherwise.
+        Or call the speck64vec_sse2_ / speck64vec_avx2_ directly (the latter only if speck64vec_avx2_supported())
+     3) speck64_clear(ctx)
+
+    eax64_speck.c built with SPECK_VEC=1 binds it to the eax64 multi-block hook.
+
+    x86 only. The code is compiled with the target attributes, so no special compiler flags are required.
+    The cpu probe is in cpux86.c, build it along.
+*/
+
+int speck64vec_avx2_supported(void);
+
+void speck64vec_sse2_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n);
+void speck64vec_avx2_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n);
+void speck64vec_encrypt_blocks(const speck64_key_t *ctx, uint64_t *blocks, unsigned int n);
+
+#endif
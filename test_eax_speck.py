@@ -0,0 +1,33 @@
+import json
+
+from cfgs import SpeckCfg
+import eax as eax
+import speck
+
+# the cipher itself is checked against the known answer from the Speck implementation guide
+KAT_KEY = bytes([0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x10, 0x11, 0x12, 0x13, 0x18, 0x19, 0x1a, 0x1b])
+KAT_PT = bytes([0x2d, 0x43, 0x75, 0x74, 0x74, 0x65, 0x72, 0x3b])
+KAT_CT = bytes([0x8b, 0x02, 0x4e, 0x45, 0x48, 0xa5, 0x6f, 0x8c])
+
+if speck.Speck64(KAT_KEY).encrypt(KAT_PT) != KAT_CT:
+    raise Exception('Speck known answer failed')
+
+# the vectors are self-generated and specific to implementation
+with open('vectors_eax_speck.json', 'r') as f:
+    VECTORS = json.load(f)
+
+    for vector in VECTORS:
+        key, nonce, header, pt, ct, tag = vector
+        key = bytes(key)
+        nonce = bytes(nonce)
+        pt = bytes(pt)
+        header = bytes(header)
+        ct = bytes(ct)
+        tag = bytes(tag)
+        enc = eax.eax_enc(SpeckCfg, key, nonce, header, pt)
+        if enc[0] != ct or enc[1] != tag:
+            raise Exception('Encrypt failed', vector, enc)
+
+        dec = eax.eax_dec(SpeckCfg, key, nonce, header, ct)
+        if dec[0] != pt or dec[1] != tag:
+            raise Exception('Decrypt failed', vector, dec)
@@ -58,6 +58,13 @@ with open('vectors_eax_xtea.h', 'w') as f:
      f.write(produce_c_vectors(vectors))
 
 
+with open('vectors_eax_speck.json', 'r') as f:
+    vectors = json.load(f)
+
+with open('vectors_eax_speck.h', 'w') as f:
+     f.write(produce_c_vectors(vectors))
+
+
 with open('vectors_eax_aes.json', 'r') as f:
     vectors = json.load(f)
 
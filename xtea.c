@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <string.h>
+#include "xtea.h"
+
+static inline uint32_t u8to32le(const uint8_t *b)
+{
+    return (b[0] << 0) | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+void xtea_set_key(xtea_key_t *ctx, const uint8_t key[16])
+{
+    const uint32_t delta = 0x9E3779B9;
+    uint32_t k[4];
+    uint32_t sum = 0;
+
+    for (int i = 0; i < 4; i++)
+        k[i] = u8to32le(&key[i * 4]);
+
+    for (int i = 0; i < 32; i++)
+    {
+        ctx->rk[i][0] = sum + k[sum & 3];
+        sum += delta;
+        ctx->rk[i][1] = sum + k[(sum >> 11) & 3];
+    }
+
+    memset(k, 0, sizeof(k));
+}
+
+uint64_t xtea_encrypt(const xtea_key_t *ctx, uint64_t block)
+{
+    uint32_t v0 = block;
+    uint32_t v1 = block >> 32;
+
+    for (int i = 0; i < 32; i++)
+    {
+        v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ ctx->rk[i][0];
+        v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ ctx->rk[i][1];
+    }
+
+    return ((uint64_t)v1 << 32) | v0;
+}
+
+// two blocks per round, the chains are independent so they overlap in the pipeline
+void xtea_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    while (n >= 2)
+    {
+        uint32_t a0 = blocks[0];
+        uint32_t a1 = blocks[0] >> 32;
+        uint32_t b0 = blocks[1];
+        uint32_t b1 = blocks[1] >> 32;
+
+        for (int i = 0; i < 32; i++)
+        {
+            a0 += (((a1 << 4) ^ (a1 >> 5)) + a1) ^ ctx->rk[i][0];
+            b0 += (((b1 << 4) ^ (b1 >> 5)) + b1) ^ ctx->rk[i][0];
+            a1 += (((a0 << 4) ^ (a0 >> 5)) + a0) ^ ctx->rk[i][1];
+            b1 += (((b0 << 4) ^ (b0 >> 5)) + b0) ^ ctx->rk[i][1];
+        }
+
+        blocks[0] = ((uint64_t)a1 << 32) | a0;
+        blocks[1] = ((uint64_t)b1 << 32) | b0;
+
+        blocks += 2;
+        n -= 2;
+    }
+
+    if (n)
+        blocks[0] = xtea_encrypt(ctx, blocks[0]);
+}
+
+void xtea_clear(xtea_key_t *ctx)
+{
+    memset(ctx, 0, sizeof(xtea_key_t));
+}
@@ -0,0 +1,33 @@
+#ifndef _XTEA_H_
+#define _XTEA_H_
+
+/*
+    XTEA, 32 rounds (64 Feistel half-rounds), 64-bit block, 128-bit key.
+
+    The key words and the round constants sum enter each half-round only as sum + key[...], which depends on
+    the key alone. So xtea_set_key schedules these 64 values once (see xtea.py), and the hot loop is
+    just shifts, adds and xors.
+
+    The block is the little-endian uint64_t of the 8 bytes, the low word is v0.
+
+    The flow is:
+     1) xtea_set_key(ctx, key)
+     2) xtea_encrypt(ctx, block) or xtea_encrypt_blocks(ctx, blocks, n)
+     3) xtea_clear(ctx)
+
+    The context is read-only while encrypting, so the single context may be shared by threads.
+    eax64_xtea.c binds it to the eax64 (the cipher_ctx is the xtea_key_t).
+    xteavec.c/h is the SSE2/AVX2 version of the xtea_encrypt_blocks.
+*/
+
+typedef struct
+{
+    uint32_t rk[32][2];     // sum + key[sum & 3], sum + delta + key[((sum + delta) >> 11) & 3] for each round
+} xtea_key_t;
+
+void xtea_set_key(xtea_key_t *ctx, const uint8_t key[16]);
+uint64_t xtea_encrypt(const xtea_key_t *ctx, uint64_t block);
+void xtea_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n);
+void xtea_clear(xtea_key_t *ctx);
+
+#endif
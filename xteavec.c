@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "xteavec.h"
+#include "cpux86.h"
+
+#define SSE2    __attribute__((target("sse2")))
+#define AVX2    __attribute__((target("avx2")))
+
+int xteavec_avx2_supported(void)
+{
+    return cpux86_avx2_supported();
+}
+
+// the blocks are [v0 v1] word pairs. shuffle of the pairs (a0 a1 b0 b1) <-> (a0 b0 a1 b1) is its own inverse,
+// the 64-bit unpacks then gather the v0 and v1 words of two registers
+
+#define ROUND128(v0, v1, k)     _mm_add_epi32(v0, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1), k))
+
+SSE2 void xteavec_sse2_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    __m128i *p = (__m128i *)blocks;
+
+    while (n >= 4)
+    {
+        __m128i x = _mm_shuffle_epi32(_mm_loadu_si128(p + 0), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i y = _mm_shuffle_epi32(_mm_loadu_si128(p + 1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i v0 = _mm_unpacklo_epi64(x, y);
+        __m128i v1 = _mm_unpackhi_epi64(x, y);
+
+        for (int i = 0; i < 32; i++)
+        {
+            v0 = ROUND128(v0, v1, _mm_set1_epi32(ctx->rk[i][0]));
+            v1 = ROUND128(v1, v0, _mm_set1_epi32(ctx->rk[i][1]));
+        }
+
+        x = _mm_unpacklo_epi64(v0, v1);
+        y = _mm_unpackhi_epi64(v0, v1);
+        _mm_storeu_si128(p + 0, _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm_storeu_si128(p + 1, _mm_shuffle_epi32(y, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        p += 2;
+        n -= 4;
+    }
+
+    if (n)
+        xtea_encrypt_blocks(ctx, (uint64_t *)p, n);
+}
+
+#define ROUND256(v0, v1, k)     _mm256_add_epi32(v0, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4), _mm256_srli_epi32(v1, 5)), v1), k))
+
+// the shuffles and unpacks work within the 128-bit halves, so the lane order is permuted. it's restored on the way back
+AVX2 void xteavec_avx2_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    __m256i *p = (__m256i *)blocks;
+
+    while (n >= 8)
+    {
+        __m256i x = _mm256_shuffle_epi32(_mm256_loadu_si256(p + 0), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i y = _mm256_shuffle_epi32(_mm256_loadu_si256(p + 1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i v0 = _mm256_unpacklo_epi64(x, y);
+        __m256i v1 = _mm256_unpackhi_epi64(x, y);
+
+        for (int i = 0; i < 32; i++)
+        {
+            v0 = ROUND256(v0, v1, _mm256_set1_epi32(ctx->rk[i][0]));
+            v1 = ROUND256(v1, v0, _mm256_set1_epi32(ctx->rk[i][1]));
+        }
+
+        x = _mm256_unpacklo_epi64(v0, v1);
+        y = _mm256_unpackhi_epi64(v0, v1);
+        _mm256_storeu_si256(p + 0, _mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256(p + 1, _mm256_shuffle_epi32(y, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        p += 2;
+        n -= 8;
+    }
+
+    if (n)
+        xteavec_sse2_encrypt_blocks(ctx, (uint64_t *)p, n);
+}
+
+void xteavec_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n)
+{
+    if (cpux86_avx2_supported())
+        xteavec_avx2_encrypt_blocks(ctx, blocks, n);
+    else
+        xteavec_sse2_encrypt_blocks(ctx, blocks, n);
+}
@@ -0,0 +1,33 @@
+#ifndef _XTEAVEC_H_
+#define _XTEAVEC_H_
+
+#include "xtea.h"
+
+/*
+    XTEA on the SSE2 and AVX2 registers.
+
+    The rounds are the 32-bit adds, shifts and xors only, so they map to the vector ops directly.
+    The blocks are split into the v0 and v1 words: a register of v0 words and a register of v1 words hold
+    4 blocks (SSE2) or 8 blocks (AVX2), and each vector round is the round of all of them.
+    The round keys are broadcast from the xtea_key_t, so the context is the same as for the portable code.
+
+    The flow is:
+     1) xtea_set_key(ctx, key)
+     2) xteavec_encrypt_blocks(ctx, blocks, n). It takes the AVX2 code if the cpu and OS support it, SSE2 otherwise.
+        Or call the xteavec_sse2_ / xteavec_avx2_ directly (the latter only if xteavec_avx2_supported())
+     3) xtea_clear(ctx)
+
+    Batches of multiple of 8 blocks are the most efficient, the tails go to the 4-way and the portable code.
+    eax64_xtea.c built with XTEA_VEC=1 binds it to the eax64 multi-block hook.
+
+    x86 only. The code is compiled with the target attributes, so no special compiler flags are required.
+    The cpu probe is in cpux86.c, build it along.
+*/
+
+int xteavec_avx2_supported(void);
+
+void xteavec_sse2_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n);
+void xteavec_avx2_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n);
+void xteavec_encrypt_blocks(const xtea_key_t *ctx, uint64_t *blocks, unsigned int n);
+
+#endif